@@ -0,0 +1,614 @@
+
+#include "jsonx.hpp"
+#include "number.hpp"
+#include "sax.hpp"
+#include "json_reader.hpp"
+#include "json_push_parser.hpp"
+#include "json_lazy.hpp"
+#include "ndjson.hpp"
+#include "cbor.hpp"
+#include "msgpack.hpp"
+#include "json_tape.hpp"
+
+#include <chrono>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <regex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace jsonx;
+
+static double seconds_since(chrono::steady_clock::time_point t0)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+static void report(const char *name, double secs, size_t items, size_t bytes)
+{
+    cout << "  " << left << setw(28) << name << right
+         << setw(10) << fixed << setprecision(1) << (secs * 1e9 / items) << " ns/item";
+    if (bytes)
+        cout << setw(10) << setprecision(1) << (bytes / secs / 1e6) << " MB/s";
+    cout << endl;
+}
+
+// Number recognition as it was done before lex_number():
+static const regex UINT_EXPR(R"(^\d+$)");
+static const regex SINT_EXPR(R"(^[+-]\d+$)");
+static const regex REAL_EXPR(R"(^-?(?:0|[1-9]\d*)(?:\.\d+)?(?:[eE][+-]?\d+)?$)");
+
+static bool regex_number(const string &s, number_t &n)
+{
+    try {
+        if (regex_match(s, UINT_EXPR)) {
+            n.type = json::UNSIGNED_T;
+            n.uint_value = stoull(s);
+            return true;
+        }
+        if (regex_match(s, SINT_EXPR)) {
+            n.type = json::SIGNED_T;
+            n.int_value = stoll(s);
+            return true;
+        }
+        if (regex_match(s, REAL_EXPR)) {
+            n.type = json::REAL_T;
+            n.real_value = stod(s);
+            return true;
+        }
+    }
+    catch (...) {
+    }
+    return false;
+}
+
+static vector<string> number_tokens(size_t count)
+{
+    mt19937_64 rng(42);
+    vector<string> v;
+    v.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        switch (i % 4) {
+        case 0:
+            v.push_back(to_string(rng() % 100000));
+            break;
+        case 1:
+            v.push_back(to_string(rng()));
+            break;
+        case 2:
+            v.push_back("-" + to_string(rng() % 1000000));
+            break;
+        default:
+        {
+            ostringstream os;
+            os << setprecision(17) << (static_cast<double>(rng() % 1000000) / 997.0);
+            v.push_back(os.str());
+        }
+        } // end switch //
+    }
+    return v;
+}
+
+static void bench_numbers()
+{
+    cout << "Number recognition:" << endl;
+    const vector<string> tokens = number_tokens(200000);
+    size_t bytes{0};
+    for (const auto &s : tokens)
+        bytes += s.size();
+
+    double sum1{0}, sum2{0};
+    auto t0 = chrono::steady_clock::now();
+    for (const auto &s : tokens) {
+        number_t n;
+        if (regex_number(s, n))
+            sum1 += (n.type == json::REAL_T) ? n.real_value : static_cast<double>(n.uint_value);
+    }
+    report("regex + stoull/stoll/stod", seconds_since(t0), tokens.size(), bytes);
+
+    t0 = chrono::steady_clock::now();
+    for (const auto &s : tokens) {
+        number_t n;
+        if (lex_number(s.data(), s.data() + s.size(), n))
+            sum2 += (n.type == json::REAL_T) ? n.real_value : static_cast<double>(n.uint_value);
+    }
+    report("lex_number", seconds_since(t0), tokens.size(), bytes);
+    if (sum1 != sum2)
+        cout << "  MISMATCH" << endl;
+
+    string doc{"["};
+    for (const auto &s : tokens)
+        doc += s + ",";
+    doc += "0]";
+    t0 = chrono::steady_clock::now();
+    json j;
+    j.parse(doc);
+    report("json::parse number array", seconds_since(t0), tokens.size(), doc.size());
+    cout << endl;
+}
+
+static string string_document(size_t count)
+{
+    string doc{"["};
+    for (size_t i = 0; i < count; ++i) {
+        doc += "{\"id\":\"" + to_string(i) + "\",\"name\":\"Record number " + to_string(i)
+            + "\",\"description\":\"A longer text value without any escapes in it, "
+              "as it is typical for most payloads\",\"note\":\"Tab\\tand \\\"quotes\\\"\"},";
+    }
+    doc += "{}]";
+    return doc;
+}
+
+static void bench_strings()
+{
+    cout << "String parsing:" << endl;
+    const size_t count{50000};
+    const string doc = string_document(count);
+    auto t0 = chrono::steady_clock::now();
+    json j;
+    j.parse(doc);
+    report("json::parse string records", seconds_since(t0), count, doc.size());
+    cout << endl;
+}
+
+static void bench_engines()
+{
+    cout << "Parse engines:" << endl;
+    const size_t count{50000};
+    const string doc = string_document(count);
+    const char *names[]{"SCANNER_E", "INDEX_E", "PARALLEL_E"};
+    for (auto engine : {json::SCANNER_E, json::INDEX_E, json::PARALLEL_E}) {
+        auto t0 = chrono::steady_clock::now();
+        json j;
+        j.parse(doc, engine);
+        report(names[engine], seconds_since(t0), count, doc.size());
+    }
+    // As received from a socket:
+    auto t0 = chrono::steady_clock::now();
+    json_push_parser p;
+    for (size_t i = 0; i < doc.size(); i += 1500)
+        p.feed(doc.data() + i, min<size_t>(1500, doc.size() - i));
+    p.finish();
+    json j = p.take();
+    report("json_push_parser", seconds_since(t0), count, doc.size());
+    cout << endl;
+}
+
+// Counts the "name" members, as a consumer aggregating a few fields would:
+struct name_counter: sax_handler {
+    size_t names{0};
+    bool in_name{false};
+
+    void on_key(string_view k) { in_name = (k == "name"); }
+    void on_string(string_view) {
+        names += in_name;
+        in_name = false;
+    }
+};
+
+static void bench_sax()
+{
+    cout << "Event parsing:" << endl;
+    const size_t count{50000};
+    const string doc = string_document(count);
+    auto t0 = chrono::steady_clock::now();
+    json j;
+    j.parse(doc);
+    size_t names1{0};
+    for (const json &v : j.toArray())
+        names1 += v.find("name").isDefined();
+    report("json::parse + find", seconds_since(t0), count, doc.size());
+    t0 = chrono::steady_clock::now();
+    name_counter h;
+    sax_parse(doc, h);
+    report("sax_parse", seconds_since(t0), count, doc.size());
+    t0 = chrono::steady_clock::now();
+    json_reader r(doc);
+    size_t names2{0};
+    while (r.next() != json_reader::END_TK) {
+        if ((r.token_type() == json_reader::KEY_TK) && (r.get_string_view() == "name")) {
+            r.next();
+            names2 += 1;
+        }
+    }
+    report("json_reader", seconds_since(t0), count, doc.size());
+    if ((names1 != h.names) || (names1 != names2))
+        cout << "  MISMATCH" << endl;
+    cout << endl;
+}
+
+static void bench_lazy()
+{
+    cout << "Reading a few fields:" << endl;
+    // About 200 KB with the fields of interest spread over the payload:
+    string doc{"{\"request\": {\"id\": 4711, \"user\": \"someone\"}, \"records\": "};
+    doc += string_document(1000);
+    doc += ", \"status\": \"done\", \"total\": 1000}";
+    const size_t rounds{200};
+    size_t sum1{0}, sum2{0};
+    auto t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        json j;
+        j.parse(doc, json::INDEX_E);
+        sum1 += j["request"]["id"].toUnsigned() + j["total"].toUnsigned()
+            + j["status"].toString().size() + j["records"][500]["id"].toString().size();
+    }
+    report("json::parse", seconds_since(t0), rounds, doc.size() * rounds);
+    t0 = chrono::steady_clock::now();
+    json_lazy lazy;
+    for (size_t r = 0; r < rounds; ++r) {
+        lazy.parse(doc);
+        sum2 += lazy["request"]["id"].toUnsigned() + lazy["total"].toUnsigned()
+            + lazy["status"].toString().size() + lazy["records"][500]["id"].toString().size();
+    }
+    report("json_lazy", seconds_since(t0), rounds, doc.size() * rounds);
+    if (sum1 != sum2)
+        cout << "  MISMATCH" << endl;
+    cout << endl;
+}
+
+static void bench_ndjson()
+{
+    cout << "NDJSON:" << endl;
+    const size_t count{200000};
+    string doc;
+    for (size_t i = 0; i < count; ++i) {
+        doc += "{\"id\":\"" + to_string(i) + "\",\"name\":\"Record number " + to_string(i)
+            + "\",\"tags\":[\"a\",\"b\",\"c\"],\"value\":" + to_string(i * 0.5) + "}\n";
+    }
+    size_t n1{0}, n2{0};
+    auto t0 = chrono::steady_clock::now();
+    istringstream is(doc);
+    string line;
+    while (getline(is, line)) {
+        json j;
+        j.parse(line);
+        n1 += j.isDefined();
+    }
+    report("getline + json::parse", seconds_since(t0), count, doc.size());
+    t0 = chrono::steady_clock::now();
+    ndjson_reader reader;
+    reader.parse(doc, [&n2](json &&j) { n2 += j.isDefined(); });
+    report("ndjson_reader", seconds_since(t0), count, doc.size());
+    if (n1 != n2)
+        cout << "  MISMATCH" << endl;
+    cout << endl;
+}
+
+static void bench_documents()
+{
+    cout << "Parse and release:" << endl;
+    const size_t count{50000};
+    const size_t rounds{5};
+    const string doc = string_document(count);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        json j;
+        j.parse(doc, json::INDEX_E);
+    }
+    report("json", seconds_since(t0), count * rounds, doc.size() * rounds);
+    t0 = chrono::steady_clock::now();
+    json_document d;
+    for (size_t r = 0; r < rounds; ++r)
+        d.parse(doc, json::INDEX_E);
+    d.reset();
+    report("json_document", seconds_since(t0), count * rounds, doc.size() * rounds);
+    cout << endl;
+}
+
+static void bench_copies()
+{
+    cout << "Copy and modify:" << endl;
+    const size_t count{50000};
+    const size_t rounds{1000};
+    json j;
+    j.parse(string_document(count));
+    size_t sum{0};
+    auto t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        json copy(j);
+        sum += copy.size();
+    }
+    report("copy", seconds_since(t0), rounds, 0);
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        json copy(j);
+        copy[static_cast<json_index_t>(r)]["id"] = "changed";
+        sum += copy.size();
+    }
+    report("copy + modify one record", seconds_since(t0), rounds, 0);
+    if (sum != 2 * rounds * (count + 1))
+        cout << "  MISMATCH" << endl;
+    cout << endl;
+}
+
+static void bench_output()
+{
+    cout << "Serialization:" << endl;
+    const size_t count{50000};
+    const size_t rounds{20};
+    string doc{"["};
+    for (size_t i = 0; i < count; ++i) {
+        doc += "{\"id\":" + to_string(i) + ",\"name\":\"Record number " + to_string(i)
+            + "\",\"value\":" + to_string(i * 0.37) + ",\"flag\":true},";
+    }
+    doc += "{}]";
+    json j;
+    j.parse(doc);
+    size_t bytes{0};
+    auto t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        ostringstream os;
+        j.write(os);
+        bytes += os.str().size();
+    }
+    report("write(std::ostream&)", seconds_since(t0), count * rounds, bytes);
+    bytes = 0;
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        bytes += j.write().size();
+    report("write()", seconds_since(t0), count * rounds, bytes);
+    bytes = 0;
+    string buffer;
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        buffer.clear();
+        j.write_to(buffer);
+        bytes += buffer.size();
+    }
+    report("write_to(std::string&)", seconds_since(t0), count * rounds, bytes);
+    bytes = 0;
+    vector<char> fixed(buffer.size());
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        bytes += j.write_to(fixed.data(), fixed.size());
+    report("write_to(char*, size_t)", seconds_since(t0), count * rounds, bytes);
+    bytes = 0;
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        buffer.clear();
+        j.write_parallel(buffer);
+        bytes += buffer.size();
+    }
+    report("write_parallel(std::string&)", seconds_since(t0), count * rounds, bytes);
+    cout << endl;
+}
+
+static void bench_binary()
+{
+    cout << "Binary encoding:" << endl;
+    const size_t count{50000};
+    const size_t rounds{20};
+    string doc{"["};
+    for (size_t i = 0; i < count; ++i) {
+        doc += "{\"id\":" + to_string(i) + ",\"name\":\"Record number " + to_string(i)
+            + "\",\"value\":" + to_string(i * 0.37) + ",\"delta\":-" + to_string(i % 1000)
+            + ",\"flag\":true},";
+    }
+    doc += "{}]";
+    json j;
+    j.parse(doc);
+    string text, cbor;
+    size_t bytes{0};
+    auto t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        text.clear();
+        j.write_to(text);
+        bytes += text.size();
+    }
+    report("write_to(std::string&)", seconds_since(t0), count * rounds, bytes);
+    bytes = 0;
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        cbor.clear();
+        to_cbor(j, cbor);
+        bytes += cbor.size();
+    }
+    report("to_cbor", seconds_since(t0), count * rounds, bytes);
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        json k;
+        k.parse(text);
+    }
+    report("json::parse", seconds_since(t0), count * rounds, text.size() * rounds);
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        json k = from_cbor(cbor);
+    report("from_cbor", seconds_since(t0), count * rounds, cbor.size() * rounds);
+    string msgpack;
+    bytes = 0;
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        msgpack.clear();
+        to_msgpack(j, msgpack);
+        bytes += msgpack.size();
+    }
+    report("to_msgpack", seconds_since(t0), count * rounds, bytes);
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        json k = from_msgpack(msgpack);
+    report("from_msgpack", seconds_since(t0), count * rounds, msgpack.size() * rounds);
+    json_document document;
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        from_msgpack(document, msgpack);
+    report("from_msgpack json_document", seconds_since(t0), count * rounds, msgpack.size() * rounds);
+    cout << "  Size: text " << text.size() << " bytes, CBOR " << cbor.size()
+         << " bytes, MessagePack " << msgpack.size() << " bytes" << endl;
+    cout << endl;
+}
+
+static void bench_tape()
+{
+    cout << "Tape files:" << endl;
+    const size_t count{50000};
+    const size_t rounds{20};
+    const size_t lookups{1000};
+    string doc{"{\"records\":["};
+    for (size_t i = 0; i < count; ++i) {
+        doc += "{\"id\":" + to_string(i) + ",\"name\":\"Record number " + to_string(i)
+            + "\",\"value\":" + to_string(i * 0.37) + ",\"flag\":true},";
+    }
+    doc += "{}]}";
+    json j;
+    j.parse(doc);
+    {
+        ofstream text("./bench.json", ios::binary);
+        text << doc;
+        ofstream tape("./bench.tape", ios::binary);
+        to_tape(j, tape);
+    }
+    size_t bytes{0};
+    auto t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        bytes += to_tape(j).size();
+    report("to_tape", seconds_since(t0), count * rounds, bytes);
+    // Open a file and look up some records:
+    uint64_t sum{0};
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        json k;
+        k.parse_file("./bench.json");
+        for (size_t i = 0; i < lookups; ++i)
+            sum += k["records"][static_cast<json_index_t>(i * 37 % count)]["id"].toUnsigned();
+    }
+    report("parse_file + lookups", seconds_since(t0), rounds, doc.size() * rounds);
+    t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        json_tape tape;
+        tape.open_file("./bench.tape");
+        for (size_t i = 0; i < lookups; ++i)
+            sum -= tape["records"][static_cast<json_index_t>(i * 37 % count)]["id"].toUnsigned();
+    }
+    report("json_tape::open_file + lookups", seconds_since(t0), rounds, 0);
+    if (sum != 0)
+        cout << "  MISMATCH" << endl;
+    cout << "  Size: text " << doc.size() << " bytes, tape " << bytes / rounds << " bytes" << endl;
+    std::remove("./bench.json");
+    std::remove("./bench.tape");
+    cout << endl;
+}
+
+static void bench_reals()
+{
+    cout << "Real numbers:" << endl;
+    const size_t count{200000};
+    mt19937_64 rng(42);
+    uniform_real_distribution<double> dist(-1e6, 1e6);
+    json a(json::ARRAY_T);
+    for (size_t i = 0; i < count; ++i)
+        a.add(dist(rng));
+    string doc;
+    auto t0 = chrono::steady_clock::now();
+    a.write_to(doc);
+    report("write real array", seconds_since(t0), count, doc.size());
+    size_t bytes{0};
+    t0 = chrono::steady_clock::now();
+    for (const json &v : a.toArray())
+        bytes += json(v).toString().size();
+    report("toString", seconds_since(t0), count, bytes);
+    t0 = chrono::steady_clock::now();
+    json b;
+    b.parse(doc);
+    report("json::parse real array", seconds_since(t0), count, doc.size());
+    if (b.size() != count)
+        cout << "  MISMATCH" << endl;
+    cout << endl;
+}
+
+static void bench_objects()
+{
+    cout << "Object lookup:" << endl;
+    const size_t lookups{1000000};
+    for (size_t count : {8, 32, 256}) {
+        vector<string> keys;
+        json obj;
+        map<string, json, less<>> tree;
+        flat_map<string, json> flat;
+        ordered_map<string, json> ordered;
+        for (size_t i = 0; i < count; ++i) {
+            keys.push_back("field_" + to_string(i * 7919 % 1000));
+            obj.add(keys.back(), json(static_cast<uint64_t>(i)));
+            tree.emplace(keys.back(), json(static_cast<uint64_t>(i)));
+            flat.emplace(keys.back(), json(static_cast<uint64_t>(i)));
+            ordered.emplace(keys.back(), json(static_cast<uint64_t>(i)));
+        }
+        const json &cobj = obj;
+        cout << "  " << count << " keys:" << endl;
+        uint64_t sum1{0}, sum2{0}, sum3{0}, sum4{0};
+        auto t0 = chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i)
+            sum1 += tree.find(keys[i % count])->second.toUnsigned();
+        report("std::map", seconds_since(t0), lookups, 0);
+        t0 = chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i)
+            sum2 += flat.find(keys[i % count])->second.toUnsigned();
+        report("flat_map", seconds_since(t0), lookups, 0);
+        t0 = chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i)
+            sum4 += ordered.find(keys[i % count])->second.toUnsigned();
+        report("ordered_map", seconds_since(t0), lookups, 0);
+        t0 = chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i)
+            sum3 += cobj.find(keys[i % count].c_str()).toUnsigned();
+        report("json::find", seconds_since(t0), lookups, 0);
+        if ((sum1 != sum2) || (sum1 != sum3) || (sum1 != sum4))
+            cout << "  MISMATCH" << endl;
+    }
+    cout << endl;
+}
+
+static void bench_keys()
+{
+    cout << "Object keys:" << endl;
+    const size_t count{1000000};
+    vector<string> names;
+    for (int i = 0; i < 40; ++i)
+        names.push_back("attribute_name_" + to_string(i));
+    size_t sum{0};
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        std::pmr::string s(names[i % names.size()]);
+        sum += s.size();
+    }
+    report("std::pmr::string", seconds_since(t0), count, 0);
+    t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        json_key k(names[i % names.size()]);
+        sum += k.size();
+    }
+    report("json_key", seconds_since(t0), count, 0);
+    if (sum == 0)
+        cout << "  MISMATCH" << endl;
+    cout << endl;
+}
+
+int main(int, const char *[])
+{
+    cout << "JsonX Bench START" << endl;
+    cout << endl;
+
+    bench_numbers();
+    bench_reals();
+    bench_strings();
+    bench_engines();
+    bench_sax();
+    bench_lazy();
+    bench_ndjson();
+    bench_documents();
+    bench_copies();
+    bench_output();
+    bench_binary();
+    bench_tape();
+    bench_objects();
+    bench_keys();
+
+    cout << "JsonX Bench FINISHED" << endl;
+    return EXIT_SUCCESS;
+}
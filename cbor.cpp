@@ -0,0 +1,373 @@
+
+#include "cbor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace jsonx {
+
+// Major types:
+static const uint8_t CBOR_UNSIGNED{0};
+static const uint8_t CBOR_NEGATIVE{1};
+static const uint8_t CBOR_BYTES{2};
+static const uint8_t CBOR_TEXT{3};
+static const uint8_t CBOR_ARRAY{4};
+static const uint8_t CBOR_MAP{5};
+static const uint8_t CBOR_TAG{6};
+static const uint8_t CBOR_SIMPLE{7};
+
+// Additional information:
+static const uint8_t CBOR_FALSE{20};
+static const uint8_t CBOR_TRUE{21};
+static const uint8_t CBOR_NULL{22};
+static const uint8_t CBOR_UNDEFINED{23};
+static const uint8_t CBOR_FLOAT16{25};
+static const uint8_t CBOR_FLOAT32{26};
+static const uint8_t CBOR_FLOAT64{27};
+static const uint8_t CBOR_INDEFINITE{31};
+
+static const uint8_t CBOR_BREAK{0xff};
+
+///////////////////////////////////////////////////////////////////////////////
+// Encoder
+///////////////////////////////////////////////////////////////////////////////
+
+static void put_head(std::string &out, uint8_t major, uint64_t n)
+{
+    char b[9];
+    size_t size;
+    const uint8_t m = static_cast<uint8_t>(major << 5);
+    if (n < 24) {
+        b[0] = static_cast<char>(m | n);
+        size = 1;
+    } else if (n <= 0xff) {
+        b[0] = static_cast<char>(m | 24);
+        size = 2;
+    } else if (n <= 0xffff) {
+        b[0] = static_cast<char>(m | 25);
+        size = 3;
+    } else if (n <= 0xffffffff) {
+        b[0] = static_cast<char>(m | 26);
+        size = 5;
+    } else {
+        b[0] = static_cast<char>(m | 27);
+        size = 9;
+    }
+    // Big endian:
+    for (size_t i = size - 1; i > 0; --i, n >>= 8)
+        b[i] = static_cast<char>(n & 0xff);
+    out.append(b, size);
+}
+
+static void put_real(std::string &out, json_real_t v)
+{
+    const float f = static_cast<float>(v);
+    if (static_cast<json_real_t>(f) == v) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        out.push_back(static_cast<char>((CBOR_SIMPLE << 5) | CBOR_FLOAT32));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back(static_cast<char>((bits >> shift) & 0xff));
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        out.push_back(static_cast<char>((CBOR_SIMPLE << 5) | CBOR_FLOAT64));
+        for (int shift = 56; shift >= 0; shift -= 8)
+            out.push_back(static_cast<char>((bits >> shift) & 0xff));
+    }
+}
+
+static void put_string(std::string &out, std::string_view s)
+{
+    put_head(out, CBOR_TEXT, s.size());
+    out.append(s.data(), s.size());
+}
+
+void to_cbor(const json &v, std::string &out)
+{
+    switch (v.getType()) {
+    case json::UNDEFINED_T:
+        out.push_back(static_cast<char>((CBOR_SIMPLE << 5) | CBOR_UNDEFINED));
+        break;
+    case json::NULL_T:
+        out.push_back(static_cast<char>((CBOR_SIMPLE << 5) | CBOR_NULL));
+        break;
+    case json::BOOL_T:
+        out.push_back(static_cast<char>((CBOR_SIMPLE << 5)
+                                        | (v.toBool() ? CBOR_TRUE : CBOR_FALSE)));
+        break;
+    case json::SIGNED_T:
+        {
+            const int64_t n = v.toSigned();
+            if (n >= 0)
+                put_head(out, CBOR_UNSIGNED, static_cast<uint64_t>(n));
+            else
+                put_head(out, CBOR_NEGATIVE, static_cast<uint64_t>(-1 - n));
+        }
+        break;
+    case json::UNSIGNED_T:
+        put_head(out, CBOR_UNSIGNED, v.toUnsigned());
+        break;
+    case json::REAL_T:
+        put_real(out, v.toReal());
+        break;
+    case json::STRING_T:
+        put_string(out, v.toStringView());
+        break;
+    case json::ARRAY_T:
+        {
+            const json_array_t &a = v.toArray();
+            put_head(out, CBOR_ARRAY, a.size());
+            for (const json &item : a)
+                to_cbor(item, out);
+        }
+        break;
+    case json::OBJECT_T:
+        {
+            const json_object_t &o = v.toObject();
+            put_head(out, CBOR_MAP, o.size());
+            for (const json_object_value_t &item : o) {
+                put_string(out, item.first);
+                to_cbor(item.second, out);
+            }
+        }
+        break;
+    default:
+        throw runtime_error("Invalid data type " + std::to_string(v.getType()));
+    } // end switch //
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Decoder
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Builds the nodes directly, json grants access for that.
+ */
+class cbor_decoder {
+public:
+    cbor_decoder(const char *data, size_t size):
+        first{reinterpret_cast<const uint8_t*>(data)}, p{first}, last{first + size} {}
+
+    void decode(json &v);
+    bool done() const { return p == last; }
+    [[noreturn]] void fail(const std::string &what) const;
+
+private:
+    void need(uint64_t n) const
+    {
+        if (n > static_cast<uint64_t>(last - p))
+            fail("Premature end of data");
+    }
+    uint64_t argument(uint8_t info);
+    // Length of an array or map, limited by the bytes left:
+    size_t count(uint64_t n) const
+    {
+        return static_cast<size_t>(std::min<uint64_t>(n, last - p));
+    }
+    void read_string(uint8_t major, uint8_t info, std::string &s);
+    json_real_t read_float(uint8_t info);
+
+    const uint8_t *first;
+    const uint8_t *p;
+    const uint8_t *last;
+    std::string    key;
+}; // end class cbor_decoder //
+
+void cbor_decoder::fail(const std::string &what) const
+{
+    throw runtime_error("Invalid CBOR: " + what + " at offset "
+                        + std::to_string(p - first));
+}
+
+uint64_t cbor_decoder::argument(uint8_t info)
+{
+    if (info < 24)
+        return info;
+    if (info > 27)
+        fail("Invalid additional information " + std::to_string(info));
+    const size_t size = size_t(1) << (info - 24);
+    need(size);
+    uint64_t n{0};
+    for (size_t i = 0; i < size; ++i)
+        n = (n << 8) | *p++;
+    return n;
+}
+
+void cbor_decoder::read_string(uint8_t major, uint8_t info, std::string &s)
+{
+    s.clear();
+    if (info != CBOR_INDEFINITE) {
+        const uint64_t n = argument(info);
+        need(n);
+        s.assign(reinterpret_cast<const char*>(p), static_cast<size_t>(n));
+        p += n;
+        return;
+    }
+    // Chunks of the same major type, up to a break:
+    while (true) {
+        need(1);
+        if (*p == CBOR_BREAK) {
+            ++p;
+            return;
+        }
+        const uint8_t b = *p++;
+        if (((b >> 5) != major) || ((b & 0x1f) == CBOR_INDEFINITE))
+            fail("Invalid string chunk");
+        const uint64_t n = argument(b & 0x1f);
+        need(n);
+        s.append(reinterpret_cast<const char*>(p), static_cast<size_t>(n));
+        p += n;
+    }
+}
+
+json_real_t cbor_decoder::read_float(uint8_t info)
+{
+    const uint64_t bits = argument(info);
+    switch (info) {
+    case CBOR_FLOAT16:
+        {
+            const int exponent = static_cast<int>((bits >> 10) & 0x1f);
+            const int mantissa = static_cast<int>(bits & 0x3ff);
+            json_real_t v;
+            if (exponent == 0)
+                v = std::ldexp(mantissa, -24);
+            else if (exponent != 31)
+                v = std::ldexp(mantissa + 1024, exponent - 25);
+            else
+                v = (mantissa == 0) ? numeric_limits<json_real_t>::infinity()
+                                    : numeric_limits<json_real_t>::quiet_NaN();
+            return (bits & 0x8000) ? -v : v;
+        }
+    case CBOR_FLOAT32:
+        {
+            const uint32_t b = static_cast<uint32_t>(bits);
+            float f;
+            memcpy(&f, &b, sizeof(f));
+            return f;
+        }
+    default:
+        {
+            json_real_t v;
+            memcpy(&v, &bits, sizeof(v));
+            return v;
+        }
+    } // end switch //
+}
+
+void cbor_decoder::decode(json &v)
+{
+    v.clear();
+    need(1);
+    const uint8_t b = *p++;
+    const uint8_t major = b >> 5;
+    const uint8_t info = b & 0x1f;
+    switch (major) {
+    case CBOR_UNSIGNED:
+        v.copyFrom(argument(info));
+        break;
+    case CBOR_NEGATIVE:
+        {
+            const uint64_t n = argument(info);
+            if (n <= static_cast<uint64_t>(numeric_limits<int64_t>::max()))
+                v.copyFrom(-1 - static_cast<int64_t>(n));
+            else
+                v.copyFrom(-1.0 - static_cast<json_real_t>(n));
+        }
+        break;
+    case CBOR_BYTES:
+    case CBOR_TEXT:
+        if (info != CBOR_INDEFINITE) {
+            const uint64_t n = argument(info);
+            need(n);
+            v.copyFrom(std::string_view(reinterpret_cast<const char*>(p), static_cast<size_t>(n)));
+            p += n;
+        } else {
+            std::string s;
+            read_string(major, info, s);
+            v.copyFrom(std::move(s));
+        }
+        break;
+    case CBOR_ARRAY:
+        v.initArray(nullptr);
+        if (info == CBOR_INDEFINITE) {
+            while (need(1), *p != CBOR_BREAK)
+                decode(v.array_value->emplace_back());
+            ++p;
+        } else {
+            const uint64_t n = argument(info);
+            v.array_value->reserve(count(n));
+            for (uint64_t i = 0; i < n; ++i)
+                decode(v.array_value->emplace_back());
+        }
+        break;
+    case CBOR_MAP:
+        {
+            v.initObject(nullptr);
+            const bool indefinite = (info == CBOR_INDEFINITE);
+            const uint64_t n = indefinite ? 0 : argument(info);
+            for (uint64_t i = 0; indefinite || (i < n); ++i) {
+                need(1);
+                if (indefinite && (*p == CBOR_BREAK)) {
+                    ++p;
+                    break;
+                }
+                const uint8_t k = *p++;
+                if ((k >> 5) != CBOR_TEXT)
+                    fail("Map key is not a text string");
+                read_string(CBOR_TEXT, k & 0x1f, key);
+                decode(v.initMember(key));
+            }
+        }
+        break;
+    case CBOR_TAG:
+        argument(info);
+        decode(v);
+        break;
+    default:
+        switch (info) {
+        case CBOR_FALSE:
+            v.copyFrom(false);
+            break;
+        case CBOR_TRUE:
+            v.copyFrom(true);
+            break;
+        case CBOR_NULL:
+            v.setNull();
+            break;
+        case CBOR_UNDEFINED:
+            break;
+        case CBOR_FLOAT16:
+        case CBOR_FLOAT32:
+        case CBOR_FLOAT64:
+            v.copyFrom(read_float(info));
+            break;
+        case CBOR_INDEFINITE:
+            --p;
+            fail("Unexpected break");
+        default:
+            --p;
+            fail("Unsupported simple value");
+        } // end switch //
+        break;
+    } // end switch //
+}
+
+json from_cbor(const char *data, size_t size)
+{
+    cbor_decoder d(data, size);
+    json v;
+    d.decode(v);
+    if (!d.done())
+        d.fail("Data behind the item");
+    return v;
+}
+
+} // end namespace jsonx //
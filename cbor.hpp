@@ -0,0 +1,46 @@
+#ifndef CBOR_HPP
+#define CBOR_HPP
+
+#include "jsonx.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace jsonx {
+
+/**
+ * @brief Append the CBOR (RFC 8949) encoding of v to out.
+ *        UNSIGNED_T and non-negative SIGNED_T values are unsigned integers,
+ *        negative SIGNED_T values negative integers, both in the shortest
+ *        form. REAL_T is a float32 if that is exact, else a float64.
+ *        UNDEFINED_T is the simple value undefined, also for array items
+ *        and object members, so these survive a round trip.
+ */
+void to_cbor(const json &v, std::string &out);
+inline std::string to_cbor(const json &v)
+{
+    std::string s;
+    to_cbor(v, s);
+    return s;
+}
+
+/**
+ * @brief Decode the CBOR data item in [data, data + size).
+ *        Unsigned integers decode as UNSIGNED_T, negative integers as
+ *        SIGNED_T (REAL_T below the range of int64_t), floats of any width
+ *        as REAL_T. Byte strings decode as strings. Indefinite lengths are
+ *        accepted, tags are skipped. Map keys must be text strings, with
+ *        duplicates the last one wins.
+ *        Throws with the offset on invalid or incomplete data and on
+ *        bytes behind the item.
+ */
+json from_cbor(const char *data, size_t size);
+inline json from_cbor(std::string_view s)
+{
+    return from_cbor(s.data(), s.size());
+}
+
+} // end namespace jsonx //
+
+#endif // CBOR_HPP
@@ -0,0 +1,54 @@
+
+#include "jsonx.hpp"
+#include "scanner.hpp"
+#include "index.hpp"
+#include "mapped_file.hpp"
+
+using namespace std;
+
+namespace jsonx {
+
+json_document::json_document(size_t initial_size): arena(initial_size)
+{
+}
+
+json_document::~json_document()
+{
+    reset();
+}
+
+void json_document::parse(std::istream &is)
+{
+    reset();
+    scanner sc(is);
+    sc.arena = &arena;
+    value.parseDocument(sc);
+}
+
+void json_document::parse(const char *data, size_t size, json::ParseEngine engine)
+{
+    reset();
+    if ((engine == json::INDEX_E) && (size <= max_indexed_size)) {
+        value.parseIndexed(data, size, &arena);
+        return;
+    }
+    // The arena is not thread-safe, PARALLEL_E parses on this thread:
+    scanner sc(data, size);
+    sc.arena = &arena;
+    value.parseDocument(sc);
+}
+
+void json_document::parse_file(const char *path, json::ParseEngine engine)
+{
+    mapped_file file(path);
+    parse(file.data(), file.size(), engine);
+}
+
+void json_document::reset()
+{
+    // The nodes are not visited, the arena drops them all at once.
+    value.clear();
+    arena.release();
+}
+
+} // end namespace jsonx //
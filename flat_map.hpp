@@ -0,0 +1,121 @@
+#ifndef FLAT_MAP_HPP
+#define FLAT_MAP_HPP
+
+#include <memory_resource>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Map with string keys, stored as a vector of pairs sorted by key.
+ *        Lookups are binary searches over contiguous memory and iteration
+ *        is a linear walk in key order, like std::map. Inserting and erasing
+ *        moves the entries behind the position, so it suits the many small
+ *        objects of typical documents better than very large ones.
+ *        Provides the subset of the std::map interface used for json objects.
+ */
+template <class Key, class T>
+class flat_map
+{
+public:
+    typedef Key                                        key_type;
+    typedef T                                          mapped_type;
+    typedef std::pair<Key, T>                          value_type;
+    typedef std::pmr::vector<value_type>               container_type;
+    typedef typename container_type::allocator_type    allocator_type;
+    typedef typename container_type::iterator          iterator;
+    typedef typename container_type::const_iterator    const_iterator;
+    typedef size_t                                     size_type;
+
+    flat_map() {}
+    flat_map(const allocator_type &alloc): items(alloc) {}
+
+    iterator begin() { return items.begin(); }
+    iterator end() { return items.end(); }
+    const_iterator begin() const { return items.begin(); }
+    const_iterator end() const { return items.end(); }
+
+    size_type size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    void clear() { items.clear(); }
+    void reserve(size_type n) { items.reserve(n); }
+
+    iterator lower_bound(std::string_view key) {
+        return items.begin() + search(key);
+    }
+    const_iterator lower_bound(std::string_view key) const {
+        return items.begin() + search(key);
+    }
+
+    iterator find(std::string_view key) {
+        iterator iter = lower_bound(key);
+        return ((iter != items.end()) && (iter->first == key))
+            ? iter : items.end();
+    }
+    const_iterator find(std::string_view key) const {
+        const_iterator iter = lower_bound(key);
+        return ((iter != items.end()) && (iter->first == key))
+            ? iter : items.end();
+    }
+
+    /**
+     * @brief Like std::map::try_emplace(): Does nothing if key is present.
+     */
+    template <class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K &&key, Args&&... args) {
+        const std::string_view k(key);
+        iterator iter = lower_bound(k);
+        if ((iter != items.end()) && (std::string_view(iter->first) == k))
+            return std::make_pair(iter, false);
+        iter = items.emplace(iter, std::piecewise_construct,
+                             std::forward_as_tuple(std::forward<K>(key)),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+        return std::make_pair(iter, true);
+    }
+
+    template <class K, class V>
+    std::pair<iterator, bool> emplace(K &&key, V &&value) {
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    iterator erase(const_iterator pos) {
+        return items.erase(pos);
+    }
+    size_type erase(std::string_view key) {
+        iterator iter = find(key);
+        if (iter == items.end())
+            return 0;
+        items.erase(iter);
+        return 1;
+    }
+
+    T& operator[](std::string_view key) {
+        return try_emplace(key).first->second;
+    }
+
+private:
+    // Binary search without a data dependent branch, so the loop
+    // does not stall on mispredictions:
+    size_type search(std::string_view key) const {
+        const value_type *first = items.data();
+        size_type len = items.size();
+        while (len > 1) {
+            const size_type half = len / 2;
+            if (std::string_view(first[half - 1].first) < key)
+                first += half;
+            len -= half;
+        }
+        if ((len == 1) && (std::string_view(first->first) < key))
+            ++first;
+        return first - items.data();
+    }
+
+    container_type items;
+}; // end class flat_map //
+
+} // end namespace jsonx //
+
+#endif // FLAT_MAP_HPP
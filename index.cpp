@@ -0,0 +1,521 @@
+#include "jsonx.hpp"
+#include "io.hpp"
+#include "index.hpp"
+#include "scanner.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSONX_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#ifdef __GNUC__
+#define JSONX_INLINE inline __attribute__((always_inline))
+#else
+#define JSONX_INLINE inline
+#endif
+
+using namespace std;
+
+namespace jsonx {
+
+///////////////////////////////////////////////////////////////////////////////
+// Stage 1: Structural index
+///////////////////////////////////////////////////////////////////////////////
+
+// Character classes of a 64 byte block, one bit per byte:
+struct block_masks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t slash;
+    uint64_t space;
+    uint64_t op;
+};
+
+// State carried from one block to the next:
+struct index_state {
+    bool in_string{false};
+    bool in_comment{false};
+    bool escape{false};
+    bool prev_other{false};
+};
+
+static inline bool is_space(unsigned char ch)
+{
+    return (ch == ' ') || ((ch >= '\t') && (ch <= '\r'));
+}
+
+static inline bool is_op(unsigned char ch)
+{
+    switch (ch) {
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+        return true;
+    default:
+        return false;
+    } // end switch //
+}
+
+static void classify_scalar(const char *p, block_masks &m)
+{
+    m = block_masks{0, 0, 0, 0, 0};
+    for (int i = 0; i < 64; ++i) {
+        unsigned char ch = static_cast<unsigned char>(p[i]);
+        uint64_t bit = 1ULL << i;
+        if (ch == '"')
+            m.quote |= bit;
+        else if (ch == '\\')
+            m.backslash |= bit;
+        else if (ch == '/')
+            m.slash |= bit;
+        else if (is_space(ch))
+            m.space |= bit;
+        else if (is_op(ch))
+            m.op |= bit;
+    } // end for //
+}
+
+#ifdef JSONX_X86_SIMD
+
+__attribute__((target("sse2")))
+static inline uint64_t eq_sse2(const __m128i v[4], char ch)
+{
+    const __m128i c = _mm_set1_epi8(ch);
+    uint64_t r{0};
+    for (int i = 0; i < 4; ++i)
+        r |= static_cast<uint64_t>(static_cast<uint16_t>(
+                 _mm_movemask_epi8(_mm_cmpeq_epi8(v[i], c)))) << (16 * i);
+    return r;
+}
+
+__attribute__((target("sse2")))
+static void classify_sse2(const char *p, block_masks &m)
+{
+    __m128i v[4];
+    for (int i = 0; i < 4; ++i)
+        v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+    m.quote     = eq_sse2(v, '"');
+    m.backslash = eq_sse2(v, '\\');
+    m.slash     = eq_sse2(v, '/');
+    m.op        = eq_sse2(v, '{') | eq_sse2(v, '}') | eq_sse2(v, '[')
+                | eq_sse2(v, ']') | eq_sse2(v, ':') | eq_sse2(v, ',');
+    // ' ' or '\t'..'\r':
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8(4);
+    uint64_t space{0};
+    for (int i = 0; i < 4; ++i) {
+        __m128i d = _mm_sub_epi8(v[i], tab);
+        __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(d, four), d);
+        space |= static_cast<uint64_t>(static_cast<uint16_t>(
+                     _mm_movemask_epi8(ctl))) << (16 * i);
+    } // end for //
+    m.space = space | eq_sse2(v, ' ');
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t eq_avx2(const __m256i v[2], char ch)
+{
+    const __m256i c = _mm256_set1_epi8(ch);
+    uint64_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v[0], c)));
+    uint64_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v[1], c)));
+    return lo | (hi << 32);
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const char *p, block_masks &m)
+{
+    __m256i v[2];
+    v[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    v[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    m.quote     = eq_avx2(v, '"');
+    m.backslash = eq_avx2(v, '\\');
+    m.slash     = eq_avx2(v, '/');
+    m.op        = eq_avx2(v, '{') | eq_avx2(v, '}') | eq_avx2(v, '[')
+                | eq_avx2(v, ']') | eq_avx2(v, ':') | eq_avx2(v, ',');
+    // ' ' or '\t'..'\r':
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8(4);
+    uint64_t space{0};
+    for (int i = 0; i < 2; ++i) {
+        __m256i d = _mm256_sub_epi8(v[i], tab);
+        __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(d, four), d);
+        space |= static_cast<uint64_t>(static_cast<uint32_t>(
+                     _mm256_movemask_epi8(ctl))) << (32 * i);
+    } // end for //
+    m.space = space | eq_avx2(v, ' ');
+}
+
+#endif // JSONX_X86_SIMD
+
+static JSONX_INLINE uint64_t prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static JSONX_INLINE void emit(uint64_t bits, uint32_t base, vector<uint32_t> &out)
+{
+    size_t n = out.size();
+    out.resize(n + __builtin_popcountll(bits));
+    uint32_t *p = out.data() + n;
+    while (bits) {
+        *p++ = base + __builtin_ctzll(bits);
+        bits &= bits - 1;
+    } // end while //
+}
+
+// Exact byte by byte state machine, used for blocks that contain comments:
+static void index_block_scalar(const char *p, size_t len, int next,
+                               index_state &st, uint32_t base,
+                               vector<uint32_t> &out)
+{
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char ch = static_cast<unsigned char>(p[i]);
+        if (st.in_comment) {
+            if (ch == '\n')
+                st.in_comment = false;
+            continue;
+        }
+        if (st.in_string) {
+            if (st.escape) {
+                st.escape = false;
+            } else if (ch == '\\') {
+                st.escape = true;
+            } else if (ch == '"') {
+                st.in_string = false;
+                out.push_back(base + static_cast<uint32_t>(i));
+            }
+            continue;
+        }
+        st.escape = false;
+        if (ch == '"') {
+            st.in_string = true;
+            st.prev_other = false;
+            out.push_back(base + static_cast<uint32_t>(i));
+        } else if ((ch == '/') && (((i + 1 < len) ? p[i + 1] : next) == '/')) {
+            st.in_comment = true;
+            st.prev_other = false;
+        } else if (is_space(ch)) {
+            st.prev_other = false;
+        } else if (is_op(ch)) {
+            st.prev_other = false;
+            out.push_back(base + static_cast<uint32_t>(i));
+        } else {
+            if (!st.prev_other)
+                out.push_back(base + static_cast<uint32_t>(i));
+            st.prev_other = true;
+        }
+    } // end for //
+}
+
+static JSONX_INLINE void index_block(const char *p, size_t len, int next,
+                                    const block_masks &m, index_state &st,
+                                    uint32_t base, vector<uint32_t> &out)
+{
+    // Characters escaped by a backslash:
+    uint64_t escaped{0};
+    uint64_t bs = m.backslash;
+    if (st.escape) {
+        escaped |= 1;
+        bs &= ~1ULL;
+    }
+    bool escape{false};
+    while (bs) {
+        int i = __builtin_ctzll(bs);
+        if (i == 63) {
+            escape = true;
+            break;
+        }
+        escaped |= 2ULL << i;
+        bs &= ~(3ULL << i);
+    } // end while //
+    // String interiors including the opening quote:
+    const uint64_t quotes = m.quote & ~escaped;
+    const uint64_t in_string = prefix_xor(quotes) ^ (st.in_string ? ~0ULL : 0);
+    // Comments need the exact state machine:
+    if (st.in_comment || (m.slash & ~in_string)) {
+        index_block_scalar(p, len, next, st, base, out);
+        return;
+    }
+    st.escape = escape;
+    st.in_string = (in_string >> 63) != 0;
+    // First characters of scalar tokens:
+    const uint64_t other = ~(m.space | m.op | m.quote | in_string);
+    const uint64_t starts = other & ~((other << 1) | (st.prev_other ? 1 : 0));
+    st.prev_other = (other >> 63) != 0;
+    emit((m.op & ~in_string) | quotes | starts, base, out);
+}
+
+template<void (*classify)(const char *, block_masks &)>
+static JSONX_INLINE void index_blocks(const char *data, size_t size,
+                                     vector<uint32_t> &out)
+{
+    index_state st;
+    block_masks m;
+    size_t pos{0};
+    for (; pos + 64 <= size; pos += 64) {
+        classify(data + pos, m);
+        int next = (pos + 64 < size) ? data[pos + 64] : -1;
+        index_block(data + pos, 64, next, m, st, static_cast<uint32_t>(pos), out);
+    } // end for //
+    if (pos < size) {
+        char tail[64];
+        memset(tail, ' ', sizeof(tail));
+        memcpy(tail, data + pos, size - pos);
+        classify(tail, m);
+        index_block(tail, size - pos, -1, m, st, static_cast<uint32_t>(pos), out);
+    }
+}
+
+static void index_scalar(const char *data, size_t size, vector<uint32_t> &out)
+{
+    index_blocks<classify_scalar>(data, size, out);
+}
+
+#ifdef JSONX_X86_SIMD
+
+__attribute__((target("sse2")))
+static void index_sse2(const char *data, size_t size, vector<uint32_t> &out)
+{
+    index_blocks<classify_sse2>(data, size, out);
+}
+
+__attribute__((target("avx2")))
+static void index_avx2(const char *data, size_t size, vector<uint32_t> &out)
+{
+    index_blocks<classify_avx2>(data, size, out);
+}
+
+#endif // JSONX_X86_SIMD
+
+typedef void (*index_fn_t)(const char *, size_t, vector<uint32_t> &);
+
+static index_fn_t select_index()
+{
+#ifdef JSONX_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return index_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return index_sse2;
+#endif
+    return index_scalar;
+}
+
+void build_structural_index(const char *data, size_t size,
+                            vector<uint32_t> &index)
+{
+    static const index_fn_t fn = select_index();
+    index.reserve(index.size() + size / 4 + 16);
+    fn(data, size, index);
+}
+
+std::string syntax_error(const char *data, size_t size, size_t pos,
+                         const std::string &what)
+{
+    // At EOF the scanner keeps the position of the last character:
+    if ((pos >= size) && (size > 0))
+        pos = size - 1;
+    int line{1};
+    int col{0};
+    if (pos < size) {
+        const char *last_nl{nullptr};
+        for (const char *p = data; p < data + pos; ++p) {
+            if (*p == '\n') {
+                line += 1;
+                last_nl = p;
+            }
+        } // end for //
+        if (data[pos] == '\n') {
+            line += 1;
+            col = 0;
+        } else if (last_nl) {
+            col = static_cast<int>(data + pos - last_nl);
+        } else {
+            col = static_cast<int>(pos) + 2;
+        }
+    } else {
+        col = 1;
+    }
+    return std::string("Syntax error ") + what
+            + " in line " + std::to_string(line)
+            + ", column " + std::to_string(col);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Stage 2: Tree construction
+///////////////////////////////////////////////////////////////////////////////
+
+void decode_string(const char *data, size_t size,
+                   size_t first, size_t last, std::string &s)
+{
+    const char *p = data + first;
+    const char *end = data + last;
+    const char *bs = static_cast<const char*>(memchr(p, '\\', end - p));
+    if (!bs) {
+        s.assign(p, end);
+        return;
+    }
+    s.assign(p, bs);
+    p = bs;
+    while (p < end) {
+        if (*p != '\\') {
+            bs = static_cast<const char*>(memchr(p, '\\', end - p));
+            if (!bs)
+                bs = end;
+            s.append(p, bs);
+            p = bs;
+            continue;
+        }
+        ++p;
+        try {
+            append_escaped(s, static_cast<unsigned char>(*p));
+        }
+        catch (const std::exception &ex) {
+            throw runtime_error(syntax_error(data, size, p - data, ex.what()));
+        }
+        ++p;
+    } // end while //
+}
+
+void json::parseIndexed(const char *data, size_t size,
+                        std::pmr::memory_resource *arena)
+{
+    vector<uint32_t> index;
+    build_structural_index(data, size, index);
+    parseIndexed(data, size, index.data(), index.size(), arena);
+}
+
+void json::parseIndexed(const char *data, size_t size,
+                        const uint32_t *idx, size_t n,
+                        std::pmr::memory_resource *arena)
+{
+    clear();
+    size_t i{0};
+    vector<json*> stack;
+    std::string key;
+
+    auto fail = [&](size_t pos, const std::string &what) {
+        throw runtime_error(syntax_error(data, size, pos, what));
+    };
+
+    // Parse the value at idx[i] into target. Containers are opened
+    // and pushed onto the stack, their contents follow in the loop below.
+    auto value = [&](json &target) {
+        if (i >= n)
+            return; // Empty token
+        const size_t pos = idx[i];
+        switch (data[pos]) {
+        case '{':
+            target.initObject(arena);
+            stack.push_back(&target);
+            ++i;
+            break;
+        case '[':
+            target.initArray(arena);
+            stack.push_back(&target);
+            ++i;
+            break;
+        case '"':
+            if (++i >= n)
+                fail(size, "Premature EOF");
+            decode_string(data, size, pos + 1, idx[i], key);
+            if (arena)
+                target.initString(key, arena);
+            else
+                target.copyFrom(std::move(key));
+            ++i;
+            break;
+        case ',':
+        case ']':
+        case '}':
+            break; // Empty token
+        default:
+            {
+                size_t end = pos;
+                while ((end < size)
+                       && !is_delimiter(static_cast<unsigned char>(data[end])))
+                    ++end;
+                std::string_view s(data + pos, end - pos);
+                if (!target.parseScalar(s))
+                    fail(end, "Unexpected token: \"" + std::string(s) + "\"");
+                while ((i < n) && (idx[i] < end))
+                    ++i;
+            }
+        } // end switch //
+    };
+
+    // Optional comma after a value inside a container:
+    auto next = [&]() {
+        if ((i < n) && (data[idx[i]] == ','))
+            ++i;
+    };
+
+    try {
+        value(*this);
+        while (!stack.empty()) {
+            json &container = *stack.back();
+            if (i >= n)
+                fail(size, "Premature EOF");
+            const size_t pos = idx[i];
+            const char ch = data[pos];
+            const size_t depth = stack.size();
+            if (container.type == ARRAY_T) {
+                if (ch == ']') {
+                    ++i;
+                    stack.pop_back();
+                    next();
+                    continue;
+                }
+                if (ch == '}')
+                    fail(pos, "Unexpected '}'");
+                json_array_t &v = *container.array_value;
+                v.emplace_back();
+                value(v.back());
+                if (stack.size() == depth) {
+                    if (!v.back().isDefined())
+                        v.pop_back();
+                    next();
+                }
+            } else {
+                if (ch == '}') {
+                    ++i;
+                    stack.pop_back();
+                    next();
+                    continue;
+                }
+                if (ch != '"')
+                    fail(pos, std::string("Expected ':', got '") + ch + "'");
+                if (++i >= n)
+                    fail(size, "Premature EOF");
+                decode_string(data, size, pos + 1, idx[i], key);
+                if (++i >= n)
+                    fail(size, "Premature EOF");
+                if (data[idx[i]] != ':')
+                    fail(idx[i], std::string("Expected ':', got '") + data[idx[i]] + "'");
+                ++i;
+                value(container.initMember(key));
+                if (stack.size() == depth)
+                    next();
+            }
+        } // end while //
+    }
+    catch (...) {
+        clear();
+        throw;
+    }
+}
+
+} // end namespace jsonx //
@@ -0,0 +1,42 @@
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Largest input the structural index can address.
+ */
+const size_t max_indexed_size{UINT32_MAX};
+
+/**
+ * @brief Stage 1 of the indexed parser.
+ *        Appends the offsets of all structural characters ({}[]:,) outside
+ *        of strings and comments, of all unescaped quotes and of the first
+ *        character of every other token to index, in ascending order.
+ *        Never fails; syntax errors are detected by stage 2.
+ */
+void build_structural_index(const char *data, size_t size,
+                            std::vector<uint32_t> &index);
+
+/**
+ * @brief Syntax error message for offset pos with the line and column
+ *        the character scanner would report there.
+ */
+std::string syntax_error(const char *data, size_t size, size_t pos,
+                         const std::string &what);
+
+/**
+ * @brief Decode the string literal contents [first, last) of data into s,
+ *        resolving escape sequences. Errors are reported like syntax_error().
+ */
+void decode_string(const char *data, size_t size,
+                   size_t first, size_t last, std::string &s);
+
+} // end namespace jsonx //
+
+#endif // INDEX_HPP
@@ -2,6 +2,10 @@
 #include "jsonx.hpp"
 #include "io.hpp"
 #include "scanner.hpp"
+#include "number.hpp"
+#include "simd.hpp"
+#include "index.hpp"
+#include "mapped_file.hpp"
 
 #include <iostream>
 #include <sstream>
@@ -9,193 +13,140 @@
 #include <vector>
 #include <stdexcept>
 #include <cctype>
-#include <regex>
 #include <cstdint>
 
 using namespace std;
 
-static const regex UINT_EXPR(R"(^\d+$)");
-static const regex SINT_EXPR(R"(^[+-]\d+$)");
-static const regex REAL_EXPR(R"(^-?(?:0|[1-9]\d*)(?:\.\d+)?(?:[eE][+-]?\d+)?$)");
-
 namespace jsonx {
 
-void serialize(ostream &ss, const string &v) {
-    ss << "\"";
-    for_each(v.begin(), v.end(), [&ss](const char ch) {
-        switch (ch) {
-        case '\0':
-            ss << "\\0";
-            break;
-        case '\"':
-            ss << "\\\"";
-            break;
-        case '\\':
-            ss << "\\\\";
-            break;
-        case '\b':
-            ss << "\\b";
-            break;
-        case '\f':
-            ss << "\\f";
-            break;
-        case '\n':
-            ss << "\\n";
-            break;
-        case '\r':
-            ss << "\\r";
-            break;
-        case '\t':
-            ss << "\\t";
-            break;
-        default:
-            ss << ch;
-            break;
-        } // end switch //
-    });
-    ss << "\"";
-}
-
-void serialize(ostream &ss, const json_array_t &v) {
-    ss << "[";
-    bool first{true};
-    for_each (v.begin(), v.end(), [&first, &ss] (const json& v) {
-        if (first)
-            first = false;
-        else
-            ss << ",";
-        v.write(ss);
-    });
-    ss << "]";
-}
-
-void serialize(ostream &ss, const json_object_t &v) {
-    ss << "{";
-    bool first{true};
-    for_each (v.begin(), v.end(), [&first, &ss] (const pair<const string, json> &v) {
-        if (v.second.isDefined()) {
-            if (first)
-                first = false;
-            else
-                ss << ",";
-            serialize(ss, v.first);
-            ss << ":";
-            v.second.write(ss);
-        }
-    });
-    ss << "}";
+static inline std::string chartostring(char c)
+{
+    return string(&c, 1);
 }
 
-void json::write(std::ostream &os) const
+void append_escaped(std::string &s, int ch)
 {
-    switch (type) {
-    case UNDEFINED_T:
+    switch (ch) {
+    case '0':
+        s.push_back('\0');
         break;
-    case NULL_T:
-        os << "null";
-        break;
-    case BOOL_T:
-        os << (bool_value ? "true" : "false");
+    case '"':
+        s.push_back('"');
         break;
-    case SIGNED_T:
-        os << int_value;
+    case '\\':
+        s.push_back('\\');
         break;
-    case UNSIGNED_T:
-        os << uint_value;
+    case 'b':
+        s.push_back('\b');
         break;
-    case REAL_T:
-        os << real_value;
+    case 'f':
+        s.push_back('\f');
         break;
-    case STRING_T:
-        ::jsonx::serialize(os, *string_value);
+    case 'n':
+        s.push_back('\n');
         break;
-    case ARRAY_T:
-        ::jsonx::serialize(os, *array_value);
+    case 'r':
+        s.push_back('\r');
         break;
-    case OBJECT_T:
-        ::jsonx::serialize(os, *object_value);
+    case 't':
+        s.push_back('\t');
         break;
+    case 'u': // Unicode not implemented for now
+        throw runtime_error("Unicode escape sequences not implemented for now");
     default:
-        cerr << "jsonx::json: Invalid data type " << type << endl;
-    } // end switch //}
-}
-
-static inline std::string chartostring(char c)
-{
-    return string(&c, 1);
+        throw runtime_error("Invalid escape sequence '\\"
+                            + chartostring(static_cast<char>(ch)) + "'");
+    } // end switch //
 }
 
-static void parse_string(jsonx::scanner &sc, std::string &s)
+void parse_string(jsonx::scanner &sc, std::string &s)
 {
     sc.skip_whitespace();
     if (sc.cur_ch != '"')
         throw runtime_error(string("Expected ':', got '") +
                             string((char*)&sc.cur_ch, 1) + "'");
-    std::ostringstream is;
+    s.clear();
+    sc.get_ch();
     while (true) {
-        sc.get_ch();
+        // Append the run up to the next quote, escape or control character:
+        const char *first = sc.data();
+        const char *last = find_string_special(first, first + sc.avail());
+        if (last != first) {
+            s.append(first, last);
+            sc.skip(last - first);
+            continue;
+        }
         if (sc.eof())
             throw runtime_error("Premature EOF");
         // End of string?:
         if (sc.cur_ch == '"') {
             sc.get_ch();
-            s = is.str();
             return;
         }
         // Not escape?
         if (sc.cur_ch != '\\') {
-            is.put(sc.cur_ch);
+            s.push_back(static_cast<char>(sc.cur_ch));
+            sc.get_ch();
             continue;
         }
         sc.get_ch();
-        switch (sc.cur_ch) {
-        case '0':
-            is.put('\0');
-            break;
-        case '"':
-            is.put('"');
-            break;
-        case '\\':
-            is.put('\\');
-            break;
-        case 'b':
-            is.put('\b');
-            break;
-        case 'f':
-            is.put('\f');
-            break;
-        case 'n':
-            is.put('\n');
-            break;
-        case 'r':
-            is.put('\r');
-            break;
-        case 't':
-            is.put('\t');
-            break;
-        case 'u': // Unicode not implemented for now
-            throw runtime_error("Unicode escape sequences not implemented for now");
-        default:
-            throw runtime_error("Invalid escape sequence '\\"
-                                + chartostring(sc.cur_ch) + "'");
-        } // end switch //
+        if (sc.eof())
+            throw runtime_error("Premature EOF");
+        append_escaped(s, sc.cur_ch);
+        sc.get_ch();
     } // end while //
 }
 
-static void parse_token(jsonx::scanner &sc, std::string &s)
+const std::string &parse_token(jsonx::scanner &sc)
 {
     sc.skip_whitespace();
-    std::ostringstream is;
-    while ((!sc.eof())
-           && (!std::isspace(sc.cur_ch))
-           && (sc.cur_ch != ',')
-           && (sc.cur_ch != ']')
-           && (sc.cur_ch != '}'))
-    {
-        is.put(sc.cur_ch);
+    std::string &s = sc.token;
+    const char *first = sc.data();
+    const char *last = first + sc.avail();
+    const char *p = first;
+    while ((p < last) && !is_delimiter(static_cast<unsigned char>(*p)))
+        ++p;
+    s.assign(first, p);
+    if (p != first)
+        sc.skip(p - first);
+    // Token continues in the next block of a stream:
+    while ((!sc.eof()) && (!is_delimiter(sc.cur_ch))) {
+        s.push_back(static_cast<char>(sc.cur_ch));
         sc.get_ch();
     }
-    s = is.str();
+    return s;
+}
+
+bool json::parseScalar(std::string_view s)
+{
+    if (s == "") {
+        type = UNDEFINED_T;
+        return true;
+    }
+    if (s == "null") {
+        type = NULL_T;
+        return true;
+    }
+    if (s == "true") {
+        type = BOOL_T;
+        bool_value = true;
+        return true;
+    }
+    if (s == "false") {
+        type = BOOL_T;
+        bool_value = false;
+        return true;
+    }
+    number_t n;
+    if (lex_number(s.data(), s.data() + s.size(), n)) {
+        type = n.type;
+        if (type == REAL_T)
+            real_value = n.real_value;
+        else
+            uint_value = n.uint_value;
+        return true;
+    }
+    return false;
 }
 
 void json::parse(jsonx::scanner &sc)
@@ -205,15 +156,13 @@ void json::parse(jsonx::scanner &sc)
     switch (sc.cur_ch) {
     case '{':
         {
-            type = OBJECT_T;
-            object_value = new json_object_t();
+            initObject(sc.arena);
             sc.get_ch();
             sc.skip_whitespace();
             while (sc.cur_ch != '}') {
                 if (sc.eof())
                     throw runtime_error("Premature EOF");
-                std::string key;
-                jsonx::parse_string(sc, key);
+                jsonx::parse_string(sc, sc.token);
                 sc.skip_whitespace();
                 if (sc.cur_ch != ':') {
                     char s[2];
@@ -223,9 +172,8 @@ void json::parse(jsonx::scanner &sc)
                 }
                 sc.get_ch();
                 sc.skip_whitespace();
-                json child;
+                json &child = initMember(sc.token);
                 child.parse(sc);
-                add(key, child);
                 sc.skip_whitespace();
                 if (sc.cur_ch == ',') {
                     sc.get_ch();
@@ -237,16 +185,19 @@ void json::parse(jsonx::scanner &sc)
         break;
     case '[':
         {
-            type = ARRAY_T;
-            array_value = new json_array_t();
+            initArray(sc.arena);
             sc.get_ch();
             sc.skip_whitespace();
             while (sc.cur_ch != ']') {
                 if (sc.eof())
                     throw runtime_error("Premature EOF");
-                json child;
-                child.parse(sc);
-                add(child);
+                if (sc.cur_ch == '}')
+                    throw runtime_error("Unexpected '}'");
+                json_array_t &v = *array_value;
+                v.emplace_back();
+                v.back().parse(sc);
+                if (!v.back().isDefined())
+                    v.pop_back();
                 sc.skip_whitespace();
                 if (sc.cur_ch == ',') {
                     sc.get_ch();
@@ -257,57 +208,24 @@ void json::parse(jsonx::scanner &sc)
         }
         break;
     case '"':
-        {
-            std::string s;
-            jsonx::parse_string(sc, s);
-            set(s);
-        }
+        jsonx::parse_string(sc, sc.token);
+        if (sc.arena)
+            initString(sc.token, sc.arena);
+        else
+            copyFrom(std::move(sc.token));
         break;
     default:
         {
-            std::string s;
-            jsonx::parse_token(sc, s);
-            if (s == "") {
-                type = UNDEFINED_T;
+            const std::string &s = jsonx::parse_token(sc);
+            if (parseScalar(s))
                 return;
-            }
-            if (s == "null") {
-                type = NULL_T;
-                return;
-            }
-            if (s == "true") {
-                type = BOOL_T;
-                bool_value = true;
-                return;
-            }
-            if (s == "false") {
-                type = BOOL_T;
-                bool_value = false;
-                return;
-            }
-            if (regex_match(s, UINT_EXPR)) {
-                type = UNSIGNED_T;
-                uint_value = std::stoull(s);
-                return;
-            }
-            if (regex_match(s, SINT_EXPR)) {
-                type = SIGNED_T;
-                uint_value = std::stoll(s);
-                return;
-            }
-            if (regex_match(s, REAL_EXPR)) {
-                type = REAL_T;
-                real_value = static_cast<json_real_t>(std::stod(s));
-                return;
-            }
             throw runtime_error(string("Unexpected token: \"" + s + "\""));
         }
     } // end switch //
 }
 
-void json::parse(std::istream &is)
+void json::parseDocument(scanner &sc)
 {
-    scanner sc(is);
     try {
         parse(sc);
     }
@@ -325,4 +243,30 @@ void json::parse(std::istream &is)
     }
 }
 
+void json::parse(std::istream &is)
+{
+    scanner sc(is);
+    parseDocument(sc);
+}
+
+void json::parse(const char *data, size_t size, ParseEngine engine)
+{
+    if ((engine == INDEX_E) && (size <= max_indexed_size)) {
+        parseIndexed(data, size, nullptr);
+        return;
+    }
+    if (engine == PARALLEL_E) {
+        parseParallel(data, size);
+        return;
+    }
+    scanner sc(data, size);
+    parseDocument(sc);
+}
+
+void json::parse_file(const char *path, ParseEngine engine)
+{
+    mapped_file file(path);
+    parse(file.data(), file.size(), engine);
+}
+
 } // end namespace jsonx //
@@ -10,9 +10,11 @@
 
 namespace jsonx {
 
-void serialize(std::ostream &os, const std::string &v);
-void serialize(std::ostream &os, const json_array_t &v);
-void serialize(std::ostream &os, const json_object_t &v);
+/**
+ * @brief Append the character for the escape sequence '\\ch' to s.
+ *        Throws on invalid escape sequences.
+ */
+void append_escaped(std::string &s, int ch);
 
 } // end namespace jsonx //
 
@@ -0,0 +1,88 @@
+
+#include "json_key.hpp"
+
+#include <cstring>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_set>
+
+using namespace std;
+
+namespace jsonx {
+
+namespace {
+
+struct entry_hash {
+    typedef void is_transparent;
+    size_t operator()(const key_entry *e) const { return e->hash; }
+    size_t operator()(string_view s) const { return hash<string_view>()(s); }
+};
+
+struct entry_equal {
+    typedef void is_transparent;
+    static string_view view(const key_entry *e) { return string_view(e->data, e->size); }
+    static string_view view(string_view s) { return s; }
+    template <class A, class B>
+    bool operator()(const A &a, const B &b) const { return view(a) == view(b); }
+};
+
+// The pool is split into shards with a lock each, so threads that intern
+// different keys rarely wait for each other:
+struct shard_t {
+    mutex                                                  lock;
+    pmr::monotonic_buffer_resource                         storage;
+    unordered_set<const key_entry*, entry_hash, entry_equal> entries;
+};
+
+const size_t SHARDS{16};
+const size_t CACHE_SIZE{256};
+
+shard_t *shards()
+{
+    // Never destroyed: Keys may be used by static objects until exit.
+    static shard_t *pool = new shard_t[SHARDS];
+    return pool;
+}
+
+} // end namespace //
+
+const key_entry *json_key::intern(string_view s)
+{
+    const size_t h = std::hash<string_view>()(s);
+    // Most lookups hit a small per thread cache and take no lock:
+    static thread_local const key_entry *cache[CACHE_SIZE];
+    const key_entry *&cached = cache[h % CACHE_SIZE];
+    if (cached && (cached->hash == h)
+        && (string_view(cached->data, cached->size) == s))
+        return cached;
+
+    shard_t &shard = shards()[(h / CACHE_SIZE) % SHARDS];
+    lock_guard<mutex> guard(shard.lock);
+    auto iter = shard.entries.find(s);
+    if (iter != shard.entries.end()) {
+        cached = *iter;
+        return cached;
+    }
+    void *p = shard.storage.allocate(offsetof(key_entry, data) + s.size() + 1,
+                                     alignof(key_entry));
+    key_entry *e = static_cast<key_entry*>(p);
+    e->hash = h;
+    e->size = s.size();
+    s.copy(e->data, s.size());
+    e->data[s.size()] = '\0';
+    shard.entries.insert(e);
+    cached = e;
+    return e;
+}
+
+size_t json_key::pool_size()
+{
+    size_t n{0};
+    for (size_t i = 0; i < SHARDS; ++i) {
+        lock_guard<mutex> guard(shards()[i].lock);
+        n += shards()[i].entries.size();
+    }
+    return n;
+}
+
+} // end namespace jsonx //
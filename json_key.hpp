@@ -0,0 +1,100 @@
+#ifndef JSON_KEY_HPP
+#define JSON_KEY_HPP
+
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace jsonx {
+
+/**
+ * @brief Entry of the global key pool. Entries are never released.
+ */
+struct key_entry {
+    size_t hash;
+    size_t size;
+    char   data[1]; // size + 1 bytes, NUL terminated
+};
+
+/**
+ * @brief Handle of an interned object key.
+ *        Equal strings give handles to the same pool entry, so a key takes
+ *        the space of one pointer and comparing two keys for equality
+ *        compares pointers. The pool is shared by all threads and keeps
+ *        every key for the lifetime of the process, so it suits the limited
+ *        set of keys of typical documents, not arbitrary data.
+ */
+class json_key
+{
+public:
+    json_key(): json_key(std::string_view()) {}
+    json_key(std::string_view s): entry{intern(s)} {}
+    json_key(const char *s): json_key(std::string_view(s)) {}
+    json_key(const std::string &s): json_key(std::string_view(s)) {}
+
+    operator std::string_view() const {
+        return std::string_view(entry->data, entry->size);
+    }
+    operator std::string() const {
+        return std::string(entry->data, entry->size);
+    }
+    const char *c_str() const { return entry->data; }
+    const char *data() const { return entry->data; }
+    size_t size() const { return entry->size; }
+    bool empty() const { return entry->size == 0; }
+    size_t hash() const { return entry->hash; }
+
+    friend bool operator==(const json_key &a, const json_key &b) {
+        return a.entry == b.entry;
+    }
+    friend bool operator==(const json_key &a, std::string_view b) {
+        // Views of interned keys point into the pool:
+        if (a.entry->data == b.data())
+            return a.entry->size == b.size();
+        return std::string_view(a) == b;
+    }
+    friend std::strong_ordering operator<=>(const json_key &a, const json_key &b) {
+        if (a.entry == b.entry)
+            return std::strong_ordering::equal;
+        return std::string_view(a) <=> std::string_view(b);
+    }
+    friend std::strong_ordering operator<=>(const json_key &a, std::string_view b) {
+        return std::string_view(a) <=> b;
+    }
+    // Not ambiguous with interning the string:
+    friend bool operator==(const json_key &a, const char *b) {
+        return a == std::string_view(b);
+    }
+    friend bool operator==(const json_key &a, const std::string &b) {
+        return a == std::string_view(b);
+    }
+    friend std::strong_ordering operator<=>(const json_key &a, const char *b) {
+        return a <=> std::string_view(b);
+    }
+    friend std::strong_ordering operator<=>(const json_key &a, const std::string &b) {
+        return a <=> std::string_view(b);
+    }
+
+    /**
+     * @brief Number of distinct keys in the pool.
+     */
+    static size_t pool_size();
+
+private:
+    static const key_entry *intern(std::string_view s);
+
+    const key_entry *entry;
+}; // end class json_key //
+
+} // end namespace jsonx //
+
+template <>
+struct std::hash<jsonx::json_key> {
+    size_t operator()(const jsonx::json_key &k) const noexcept {
+        return k.hash();
+    }
+};
+
+#endif // JSON_KEY_HPP
@@ -0,0 +1,407 @@
+
+#include "json_lazy.hpp"
+#include "index.hpp"
+#include "mapped_file.hpp"
+#include "number.hpp"
+#include "scanner.hpp"
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+
+namespace jsonx {
+
+///////////////////////////////////////////////////////////////////////////////
+// json_lazy
+///////////////////////////////////////////////////////////////////////////////
+
+json_lazy::json_lazy()
+{
+}
+
+json_lazy::~json_lazy()
+{
+}
+
+void json_lazy::parse(const char *_data, size_t _size)
+{
+    file.reset();
+    buffer.clear();
+    data = _data;
+    size = _size;
+    build();
+}
+
+void json_lazy::parse(std::string &&s)
+{
+    file.reset();
+    buffer = std::move(s);
+    data = buffer.data();
+    size = buffer.size();
+    build();
+}
+
+void json_lazy::parse_file(const char *path)
+{
+    buffer.clear();
+    file = make_unique<mapped_file>(path);
+    data = file->data();
+    size = file->size();
+    build();
+}
+
+void json_lazy::build()
+{
+    // Built aside, so a failed parse leaves no half-matched index behind:
+    index.clear();
+    match.clear();
+    if (size > max_indexed_size)
+        throw runtime_error("Input too large for json_lazy");
+    vector<uint32_t> new_index;
+    build_structural_index(data, size, new_index);
+    vector<uint32_t> new_match(new_index.size(), 0);
+    vector<uint32_t> open;
+    for (size_t i = 0; i < new_index.size(); ++i) {
+        const char ch = data[new_index[i]];
+        switch (ch) {
+        case '"':
+            ++i; // Closing quote
+            break;
+        case '{':
+        case '[':
+            open.push_back(static_cast<uint32_t>(i));
+            break;
+        case '}':
+        case ']':
+            if (open.empty() || (data[new_index[open.back()]] != ((ch == '}') ? '{' : '[')))
+                fail(new_index[i], string("Unexpected '") + ch + "'");
+            new_match[open.back()] = static_cast<uint32_t>(i + 1);
+            open.pop_back();
+            break;
+        default:
+            break;
+        } // end switch //
+    }
+    if (!open.empty())
+        fail(size, "Premature EOF");
+    index.swap(new_index);
+    match.swap(new_match);
+}
+
+size_t json_lazy::after(size_t i) const
+{
+    if (i >= index.size())
+        return i;
+    switch (data[index[i]]) {
+    case '{':
+    case '[':
+        return match[i];
+    case '"':
+        return i + 2;
+    case ',':
+    case ':':
+    case ']':
+    case '}':
+        return i;
+    default:
+        return i + 1;
+    } // end switch //
+}
+
+size_t json_lazy::end_of(size_t i) const
+{
+    switch (data[index[i]]) {
+    case '{':
+    case '[':
+        return index[match[i] - 1] + 1;
+    case '"':
+        if (i + 1 >= index.size())
+            fail(size, "Premature EOF");
+        return index[i + 1] + 1;
+    case ',':
+    case ':':
+    case ']':
+    case '}':
+        return index[i];
+    default:
+    {
+        size_t end = index[i];
+        while ((end < size) && !is_delimiter(static_cast<unsigned char>(data[end])))
+            ++end;
+        return end;
+    }
+    } // end switch //
+}
+
+void json_lazy::fail(size_t offset, const std::string &what) const
+{
+    throw runtime_error(syntax_error(data, size, offset, what));
+}
+
+const json_lazy_value json_lazy::root() const
+{
+    if (index.empty())
+        return json_lazy_value();
+    switch (data[index[0]]) {
+    case ',':
+    case ':':
+    case ']':
+    case '}':
+        return json_lazy_value();
+    default:
+        return json_lazy_value(this, 0);
+    } // end switch //
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// json_lazy_value
+///////////////////////////////////////////////////////////////////////////////
+
+bool json_lazy_value::isString() const
+{
+    return isDefined() && (doc->data[doc->index[pos]] == '"');
+}
+
+bool json_lazy_value::isArray() const
+{
+    return isDefined() && (doc->data[doc->index[pos]] == '[');
+}
+
+bool json_lazy_value::isObject() const
+{
+    return isDefined() && (doc->data[doc->index[pos]] == '{');
+}
+
+json::DataType json_lazy_value::getType() const
+{
+    if (!isDefined())
+        return json::UNDEFINED_T;
+    switch (doc->data[doc->index[pos]]) {
+    case '{':
+        return json::OBJECT_T;
+    case '[':
+        return json::ARRAY_T;
+    case '"':
+        return json::STRING_T;
+    default:
+        return scalar().getType();
+    } // end switch //
+}
+
+size_t json_lazy_value::size() const
+{
+    if (isArray()) {
+        const vector<uint32_t> &index = doc->index;
+        const char *data = doc->data;
+        size_t n{0};
+        size_t j = pos + 1;
+        while ((j < index.size()) && (data[index[j]] != ']')) {
+            const char ch = data[index[j]];
+            if ((ch == '}') || (ch == ':'))
+                doc->fail(index[j], string("Unexpected '") + ch + "'");
+            if (ch != ',') {
+                n += 1;
+                j = doc->after(j);
+            }
+            if ((j < index.size()) && (data[index[j]] == ','))
+                ++j;
+        }
+        return n;
+    }
+    if (isObject()) {
+        // Duplicate keys count once, the last value decides:
+        const vector<uint32_t> &index = doc->index;
+        const char *data = doc->data;
+        map<string, bool> members;
+        string key;
+        size_t j = pos + 1;
+        while ((j < index.size()) && (data[index[j]] != '}')) {
+            if (data[index[j]] == ',') {
+                ++j;
+                continue;
+            }
+            if ((data[index[j]] != '"') || (j + 2 >= index.size()))
+                doc->fail(index[j], string("Expected ':', got '") + data[index[j]] + "'");
+            decode_string(data, doc->size, index[j] + 1, index[j + 1], key);
+            j += 2;
+            if (data[index[j]] != ':')
+                doc->fail(index[j], string("Expected ':', got '") + data[index[j]] + "'");
+            ++j;
+            const size_t value = j;
+            j = doc->after(j);
+            members[key] = (j != value);
+        }
+        size_t n{0};
+        for (const auto &m : members)
+            n += m.second;
+        return n;
+    }
+    return isDefined() ? 1 : 0;
+}
+
+const json_lazy_value json_lazy_value::at(size_t i) const
+{
+    if (!isArray())
+        return json_lazy_value();
+    const vector<uint32_t> &index = doc->index;
+    const char *data = doc->data;
+    size_t j = pos + 1;
+    while ((j < index.size()) && (data[index[j]] != ']')) {
+        const char ch = data[index[j]];
+        if (ch == ',') {
+            // Empty item:
+            ++j;
+            continue;
+        }
+        if ((ch == '}') || (ch == ':'))
+            doc->fail(index[j], string("Unexpected '") + ch + "'");
+        if (i == 0)
+            return json_lazy_value(doc, j);
+        --i;
+        j = doc->after(j);
+        if ((j < index.size()) && (data[index[j]] == ','))
+            ++j;
+    }
+    return json_lazy_value();
+}
+
+const json_lazy_value json_lazy_value::find(std::string_view key) const
+{
+    if (!isObject())
+        return json_lazy_value();
+    const vector<uint32_t> &index = doc->index;
+    const char *data = doc->data;
+    size_t found{NONE};
+    string decoded;
+    size_t j = pos + 1;
+    while ((j < index.size()) && (data[index[j]] != '}')) {
+        if (data[index[j]] == ',') {
+            ++j;
+            continue;
+        }
+        if ((data[index[j]] != '"') || (j + 2 >= index.size()))
+            doc->fail(index[j], string("Expected ':', got '") + data[index[j]] + "'");
+        const char *first = data + index[j] + 1;
+        const char *last = data + index[j + 1];
+        bool equal;
+        if (memchr(first, '\\', last - first)) {
+            decode_string(data, doc->size, first - data, last - data, decoded);
+            equal = (decoded == key);
+        } else {
+            equal = (string_view(first, last - first) == key);
+        }
+        j += 2;
+        if (data[index[j]] != ':')
+            doc->fail(index[j], string("Expected ':', got '") + data[index[j]] + "'");
+        ++j;
+        const size_t value = j;
+        j = doc->after(j);
+        // Duplicate keys: the last one wins.
+        if (equal)
+            found = (j != value) ? value : NONE;
+    }
+    return (found == NONE) ? json_lazy_value() : json_lazy_value(doc, found);
+}
+
+std::string_view json_lazy_value::raw() const
+{
+    if (!isDefined())
+        return std::string_view();
+    const size_t first = doc->index[pos];
+    return std::string_view(doc->data + first, doc->end_of(pos) - first);
+}
+
+bool json_lazy_value::toBool() const
+{
+    if (isArray() || isObject())
+        return size() != 0;
+    return scalar().toBool();
+}
+
+int64_t json_lazy_value::toSigned() const
+{
+    if (isArray() || isObject())
+        return size();
+    return scalar().toSigned();
+}
+
+uint64_t json_lazy_value::toUnsigned() const
+{
+    if (isArray() || isObject())
+        return size();
+    return scalar().toUnsigned();
+}
+
+json_real_t json_lazy_value::toReal() const
+{
+    if (isArray() || isObject())
+        return static_cast<json_real_t>(size());
+    return scalar().toReal();
+}
+
+json_string_t json_lazy_value::toString() const
+{
+    if (!isString())
+        return json_string_t();
+    json_string_t s;
+    decode_string(doc->data, doc->size, doc->index[pos] + 1, doc->end_of(pos) - 1, s);
+    return s;
+}
+
+json json_lazy_value::toJson() const
+{
+    if (isArray() || isObject()) {
+        // On the index of the document, so errors report their position
+        // in the document:
+        json v;
+        v.parseIndexed(doc->data, doc->size, doc->index.data() + pos,
+                       doc->match[pos] - pos, nullptr);
+        return v;
+    }
+    return scalar();
+}
+
+json json_lazy_value::scalar() const
+{
+    if (!isDefined())
+        return json();
+    const char *data = doc->data;
+    const size_t first = doc->index[pos];
+    switch (data[first]) {
+    case '{':
+    case '[':
+        return json();
+    case '"':
+    {
+        string s;
+        decode_string(data, doc->size, first + 1, doc->end_of(pos) - 1, s);
+        return json(s);
+    }
+    default:
+    {
+        const string_view s = raw();
+        if (s == "null")
+            return json(json::NULL_T);
+        if (s == "true")
+            return json(true);
+        if (s == "false")
+            return json(false);
+        number_t n;
+        if (lex_number(s.data(), s.data() + s.size(), n)) {
+            switch (n.type) {
+            case json::SIGNED_T:
+                return json(n.int_value);
+            case json::UNSIGNED_T:
+                return json(n.uint_value);
+            default:
+                return json(n.real_value);
+            } // end switch //
+        }
+        doc->fail(first + s.size(), "Unexpected token: \"" + string(s) + "\"");
+    }
+    } // end switch //
+}
+
+} // end namespace jsonx //
@@ -0,0 +1,150 @@
+#ifndef JSON_LAZY_HPP
+#define JSON_LAZY_HPP
+
+#include "jsonx.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jsonx {
+
+class json_lazy;
+class mapped_file;
+
+/**
+ * @brief Read-only view of a value inside a json_lazy document.
+ *        Holds a position only; looking up members and items skips over
+ *        the values in between without converting them, and scalars are
+ *        converted when a toX() function is called. Views are invalidated
+ *        by parsing another document into the json_lazy or destroying it.
+ *        Conversions follow the rules of the json class.
+ */
+class json_lazy_value {
+public:
+    json_lazy_value() {}
+
+    json::DataType getType() const;
+    bool isDefined() const { return pos != NONE; }
+    bool isNull() const { return getType() == json::NULL_T; }
+    bool isString() const;
+    bool isArray() const;
+    bool isObject() const;
+
+    /**
+     * @brief Number of items or defined members, like json::size().
+     */
+    size_t size() const;
+
+    const json_lazy_value at(size_t i) const;
+    const json_lazy_value operator[] (json_index_t i) const {
+        return at(static_cast<size_t>(i));
+    }
+    /**
+     * @brief Member key, undefined if missing. With duplicate keys the last
+     *        one wins, as in json::parse().
+     */
+    const json_lazy_value find(std::string_view key) const;
+    const json_lazy_value operator[] (const char *key) const {
+        return find(key);
+    }
+    const json_lazy_value operator[] (const std::string &key) const {
+        return find(key);
+    }
+
+    // Arrays and objects convert to their size() without being built:
+    bool toBool() const;
+    int64_t toSigned() const;
+    uint64_t toUnsigned() const;
+    int toInt() const { return static_cast<int>(toSigned()); }
+    json_real_t toReal() const;
+    // Empty for values that are no strings, like json::toString() const:
+    json_string_t toString() const;
+
+    /**
+     * @brief Build this value, including all children, as a json tree.
+     */
+    json toJson() const;
+
+    /**
+     * @brief Source text of the value.
+     */
+    std::string_view raw() const;
+
+private:
+    friend class json_lazy;
+
+    static const size_t NONE{SIZE_MAX};
+
+    json_lazy_value(const json_lazy *_doc, size_t _pos): doc{_doc}, pos{_pos} {}
+    // Value of a scalar or string, undefined for arrays and objects:
+    json scalar() const;
+
+    const json_lazy *doc{nullptr};
+    size_t           pos{NONE};  // Position in the structural index
+}; // end class json_lazy_value //
+
+/**
+ * @brief Document that is parsed on demand. parse() only builds the
+ *        structural index of the input and matches the brackets, values
+ *        are located and converted when they are accessed through the
+ *        json_lazy_value views. Suits reading a few fields out of large
+ *        inputs. The input passed to parse() is not copied and must
+ *        outlive the document, unless it is moved in as a std::string.
+ *        Inputs larger than max_indexed_size are not supported.
+ */
+class json_lazy {
+public:
+    json_lazy();
+    json_lazy(const json_lazy&) = delete;
+    json_lazy& operator=(const json_lazy&) = delete;
+    ~json_lazy();
+
+    // IO:
+    void parse(const char *data, size_t size);
+    void parse(std::string_view s) {
+        parse(s.data(), s.size());
+    }
+    void parse(const char *s) {
+        parse(std::string_view(s));
+    }
+    void parse(std::string &&s);
+    void parse_file(const char *path);
+
+    // Access:
+    const json_lazy_value root() const;
+    const json_lazy_value operator[] (json_index_t i) const {
+        return root()[i];
+    }
+    const json_lazy_value operator[] (const char *key) const {
+        return root()[key];
+    }
+    const json_lazy_value operator[] (const std::string &key) const {
+        return root()[key];
+    }
+
+private:
+    friend class json_lazy_value;
+
+    void build();
+    // Index position behind the value at i:
+    size_t after(size_t i) const;
+    // Offset behind the last character of the value at i:
+    size_t end_of(size_t i) const;
+    [[noreturn]] void fail(size_t offset, const std::string &what) const;
+
+    const char                  *data{nullptr};
+    size_t                       size{0};
+    std::string                  buffer;
+    std::unique_ptr<mapped_file> file;
+    std::vector<uint32_t>        index;
+    // For the index of a '{' or '[': the index behind its matching bracket:
+    std::vector<uint32_t>        match;
+}; // end class json_lazy //
+
+} // end namespace jsonx //
+
+#endif // JSON_LAZY_HPP
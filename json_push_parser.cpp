@@ -0,0 +1,280 @@
+
+#include "json_push_parser.hpp"
+#include "io.hpp"
+#include "scanner.hpp"
+#include "simd.hpp"
+
+#include <cctype>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace jsonx {
+
+// The states mirror json::parse(scanner&), so that the trees and the
+// errors are the same.
+
+void json_push_parser::consume(int ch)
+{
+    if (ch == '\n') {
+        cur_line += 1;
+        cur_col = 0;
+    } else {
+        cur_col += 1;
+    }
+}
+
+void json_push_parser::fail(const std::exception &ex, int ch)
+{
+    // Position of ch, as the scanner reports it:
+    int line{cur_line}, col{cur_col};
+    if (ch == '\n') {
+        line += 1;
+        col = 0;
+    } else if (ch != EOF) {
+        col += 1;
+    }
+    reset();
+    throw runtime_error(std::string("Syntax error ") + ex.what()
+                        + " in line " + std::to_string(line)
+                        + ", column " + std::to_string(col));
+}
+
+void json_push_parser::end_value()
+{
+    if (stack.empty()) {
+        state = COMPLETE_S;
+        return;
+    }
+    json &parent = *stack.back();
+    if (parent.isArray() && !parent.array_value->back().isDefined())
+        parent.array_value->pop_back();
+    state = NEXT_S;
+}
+
+bool json_push_parser::step(int ch, int next)
+{
+    switch (state) {
+    case VALUE_S:
+    case ITEMS_S:
+    case MEMBERS_S:
+    case COLON_S:
+    case NEXT_S:
+        // Whitespace and comments:
+        if (ch == EOF)
+            break;
+        if (in_comment) {
+            if (ch == '\n')
+                in_comment = false;
+            consume(ch);
+            return true;
+        }
+        if (std::isspace(ch)) {
+            consume(ch);
+            return true;
+        }
+        if (ch == '/') {
+            if (next == UNKNOWN) {
+                slash = true;
+                return true;
+            }
+            if (next == '/') {
+                in_comment = true;
+                consume(ch);
+                return true;
+            }
+        }
+        break;
+    default:
+        break;
+    } // end switch //
+
+    switch (state) {
+    case VALUE_S:
+        target->clear();
+        switch (ch) {
+        case '{':
+            target->initObject(nullptr);
+            stack.push_back(target);
+            state = MEMBERS_S;
+            break;
+        case '[':
+            target->initArray(nullptr);
+            stack.push_back(target);
+            state = ITEMS_S;
+            break;
+        case '"':
+            text.clear();
+            key = false;
+            state = STRING_S;
+            break;
+        default:
+            text.clear();
+            state = TOKEN_S;
+            return false;
+        } // end switch //
+        break;
+    case TOKEN_S:
+        if ((ch != EOF) && !is_delimiter(ch)) {
+            text.push_back(static_cast<char>(ch));
+            break;
+        }
+        if (!target->parseScalar(text))
+            throw runtime_error(string("Unexpected token: \"" + text + "\""));
+        end_value();
+        return false;
+    case STRING_S:
+        if (ch == EOF)
+            throw runtime_error("Premature EOF");
+        if (ch == '\\') {
+            state = ESCAPE_S;
+        } else if (ch != '"') {
+            text.push_back(static_cast<char>(ch));
+        } else if (key) {
+            state = COLON_S;
+        } else {
+            target->copyFrom(std::move(text));
+            end_value();
+        }
+        break;
+    case ESCAPE_S:
+        if (ch == EOF)
+            throw runtime_error("Premature EOF");
+        append_escaped(text, ch);
+        state = STRING_S;
+        break;
+    case ITEMS_S:
+        if (ch == ']') {
+            stack.pop_back();
+            end_value();
+            break;
+        }
+        if (ch == EOF)
+            throw runtime_error("Premature EOF");
+        if (ch == '}')
+            throw runtime_error("Unexpected '}'");
+        target = &stack.back()->array_value->emplace_back();
+        state = VALUE_S;
+        return false;
+    case MEMBERS_S:
+        if (ch == '}') {
+            stack.pop_back();
+            end_value();
+            break;
+        }
+        if (ch == EOF)
+            throw runtime_error("Premature EOF");
+        if (ch != '"') {
+            throw runtime_error(string("Expected ':', got '")
+                                + static_cast<char>(ch) + "'");
+        }
+        text.clear();
+        key = true;
+        state = STRING_S;
+        break;
+    case COLON_S:
+        if (ch != ':') {
+            throw runtime_error(string("Expected ':', got '")
+                                + static_cast<char>(ch) + "'");
+        }
+        target = &stack.back()->initMember(text);
+        state = VALUE_S;
+        break;
+    case NEXT_S:
+        state = stack.back()->isArray() ? ITEMS_S : MEMBERS_S;
+        if (ch != ',')
+            return false;
+        break;
+    default:
+        return false;
+    } // end switch //
+    consume(ch);
+    return true;
+}
+
+size_t json_push_parser::feed(const char *data, size_t size)
+{
+    const unsigned char *first = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char *p = first;
+    const unsigned char *end = first + size;
+    int ch{EOF};
+    try {
+        if (slash && (p < end) && (state != COMPLETE_S)) {
+            slash = false;
+            ch = '/';
+            while (!step('/', *p))
+                ;
+        }
+        while ((p < end) && (state != COMPLETE_S)) {
+            // Runs within strings and tokens:
+            if (state == STRING_S) {
+                const unsigned char *q = reinterpret_cast<const unsigned char*>(
+                    find_string_special(reinterpret_cast<const char*>(p),
+                                        reinterpret_cast<const char*>(end)));
+                text.append(reinterpret_cast<const char*>(p), q - p);
+                cur_col += static_cast<int>(q - p);
+                p = q;
+                if (p == end)
+                    break;
+            } else if (state == TOKEN_S) {
+                const unsigned char *q = p;
+                while ((q < end) && !is_delimiter(*q))
+                    ++q;
+                text.append(reinterpret_cast<const char*>(p), q - p);
+                cur_col += static_cast<int>(q - p);
+                p = q;
+                if (p == end)
+                    break;
+            }
+            ch = *p;
+            if (step(ch, (p + 1 < end) ? p[1] : UNKNOWN))
+                ++p;
+        } // end while //
+    }
+    catch (const std::exception &ex) {
+        fail(ex, ch);
+    }
+    return p - first;
+}
+
+void json_push_parser::finish()
+{
+    int ch{EOF};
+    try {
+        if (slash && (state != COMPLETE_S)) {
+            slash = false;
+            ch = '/';
+            while (!step('/', EOF))
+                ;
+        }
+        ch = EOF;
+        while (state != COMPLETE_S)
+            step(EOF, EOF);
+    }
+    catch (const std::exception &ex) {
+        fail(ex, ch);
+    }
+}
+
+json json_push_parser::take()
+{
+    json v(std::move(value));
+    value.clear();
+    state = VALUE_S;
+    stack.clear();
+    target = &value;
+    text.clear();
+    return v;
+}
+
+void json_push_parser::reset()
+{
+    take();
+    in_comment = false;
+    slash = false;
+    cur_line = 1;
+    cur_col = 1;
+}
+
+} // end namespace jsonx //
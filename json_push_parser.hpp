@@ -0,0 +1,106 @@
+#ifndef JSON_PUSH_PARSER_HPP
+#define JSON_PUSH_PARSER_HPP
+
+#include "jsonx.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Push parser: the input is passed in pieces of any size as it
+ *        arrives, e.g. network packets, and never blocks waiting for more.
+ *        Partial tokens, strings and the open objects and arrays are kept
+ *        between the calls to feed(). Accepts the same input as
+ *        json::parse() and builds the same tree.
+ *        Several values may follow each other in the input: feed() stops
+ *        behind a complete value, which is then taken out with take().
+ *        Errors throw with the line and column, counted from the start of
+ *        the input, like json::parse(), and reset the parser.
+ */
+class json_push_parser
+{
+public:
+    json_push_parser() {}
+    json_push_parser(const json_push_parser&) = delete;
+    json_push_parser& operator=(const json_push_parser&) = delete;
+
+    /**
+     * @brief Parse the next piece of input. Stops when a value is complete,
+     *        the rest of the input then belongs to the next value and must
+     *        be fed again after take(). Consumes nothing while complete().
+     * @return Number of bytes consumed.
+     */
+    size_t feed(const char *data, size_t size);
+    size_t feed(std::string_view s) {
+        return feed(s.data(), s.size());
+    }
+
+    /**
+     * @brief End of the input. Completes a number or literal at the very
+     *        end, throws if a value is incomplete. Afterwards complete() is
+     *        true, an input without a value yields an undefined value.
+     */
+    void finish();
+
+    bool complete() const { return state == COMPLETE_S; }
+
+    /**
+     * @brief Take the complete value and start the next one.
+     */
+    json take();
+
+    /**
+     * @brief Drop the input so far, including the position.
+     */
+    void reset();
+
+    /**
+     * @brief Number of objects and arrays open.
+     */
+    size_t depth() const { return stack.size(); }
+    // Position of the last character consumed:
+    int line() const { return cur_line; }
+    int column() const { return cur_col; }
+
+private:
+    typedef enum {
+        /*0*/ VALUE_S,    // Before a value
+        /*1*/ TOKEN_S,    // In a number or literal
+        /*2*/ STRING_S,   // In a string or key
+        /*3*/ ESCAPE_S,   // Behind a backslash in a string or key
+        /*4*/ ITEMS_S,    // In an array, before an item or ']'
+        /*5*/ MEMBERS_S,  // In an object, before a key or '}'
+        /*6*/ COLON_S,    // In an object, behind a key
+        /*7*/ NEXT_S,     // In an array or object, behind a value
+        /*8*/ COMPLETE_S  // Behind the top-level value
+    } State;
+
+    // Lookahead behind the end of the piece fed:
+    static const int UNKNOWN{-2};
+
+    // Process ch, with next the character after it.
+    // Returns false if ch is left for the next state.
+    bool step(int ch, int next);
+    void end_value();
+    void consume(int ch);
+    [[noreturn]] void fail(const std::exception &ex, int ch);
+
+    json               value;
+    State              state{VALUE_S};
+    std::vector<json*> stack;               // Open objects and arrays
+    json              *target{&value};      // Value being parsed
+    std::string        text;                // Token, string or key so far
+    bool               key{false};          // text is a key
+    bool               in_comment{false};
+    bool               slash{false};        // A '/' waits for the next piece
+    int                cur_line{1};
+    int                cur_col{1};          // Of the last character consumed
+}; // end class json_push_parser //
+
+} // end namespace jsonx //
+
+#endif // JSON_PUSH_PARSER_HPP
@@ -0,0 +1,183 @@
+
+#include "json_reader.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace jsonx {
+
+json_reader::TokenType json_reader::next()
+{
+    try {
+        token = m.step(sc);
+    }
+    catch (const std::exception &ex) {
+        throw runtime_error(std::string("Syntax error ") + ex.what()
+                            + " in line " + std::to_string(sc.cur_line)
+                            + ", column " + std::to_string(sc.cur_col));
+    }
+    return token;
+}
+
+json_reader::TokenType json_reader::machine::step(scanner &sc)
+{
+    while (true) {
+        if (value) {
+            value = false;
+            item = true;
+            sc.skip_whitespace();
+            switch (sc.cur_ch) {
+            case '{':
+                sc.get_ch();
+                stack.push_back('}');
+                item = false;
+                return START_OBJECT_TK;
+            case '[':
+                sc.get_ch();
+                stack.push_back(']');
+                item = false;
+                return START_ARRAY_TK;
+            case '"':
+                parse_string(sc, sc.token);
+                return STRING_TK;
+            default:
+            {
+                const std::string &s = parse_token(sc);
+                if (s.empty())
+                    break;
+                if (s == "null") {
+                    number.type = json::NULL_T;
+                    return NULL_TK;
+                }
+                if ((s == "true") || (s == "false")) {
+                    number.type = json::BOOL_T;
+                    number.uint_value = (s == "true");
+                    return BOOL_TK;
+                }
+                if (!lex_number(s.data(), s.data() + s.size(), number))
+                    throw runtime_error(string("Unexpected token: \"" + s + "\""));
+                switch (number.type) {
+                case json::SIGNED_T:
+                    return SIGNED_TK;
+                case json::UNSIGNED_T:
+                    return UNSIGNED_TK;
+                default:
+                    return REAL_TK;
+                } // end switch //
+            }
+            } // end switch //
+        }
+        if (stack.empty())
+            return END_TK;
+        sc.skip_whitespace();
+        if (item && (sc.cur_ch == ',')) {
+            sc.get_ch();
+            sc.skip_whitespace();
+        }
+        item = true;
+        if (sc.cur_ch == stack.back()) {
+            const char closing = stack.back();
+            sc.get_ch();
+            stack.pop_back();
+            return (closing == '}') ? END_OBJECT_TK : END_ARRAY_TK;
+        }
+        if (sc.eof())
+            throw runtime_error("Premature EOF");
+        if (stack.back() == ']') {
+            if (sc.cur_ch == '}')
+                throw runtime_error("Unexpected '}'");
+            // Empty item:
+            if (is_delimiter(sc.cur_ch))
+                continue;
+            value = true;
+        } else {
+            parse_string(sc, sc.token);
+            sc.skip_whitespace();
+            if (sc.cur_ch != ':') {
+                char s[2];
+                s[0] = sc.cur_ch;
+                s[1] = '\0';
+                throw runtime_error(string("Expected ':', got '") + s + "'");
+            }
+            sc.get_ch();
+            sc.skip_whitespace();
+            // Member without value:
+            if (sc.eof() || is_delimiter(sc.cur_ch))
+                continue;
+            value = true;
+            return KEY_TK;
+        }
+    } // end while //
+}
+
+void json_reader::skip_value()
+{
+    if (token == KEY_TK)
+        next();
+    if ((token == START_OBJECT_TK) || (token == START_ARRAY_TK)) {
+        const size_t level = m.depth();
+        while (m.depth() >= level)
+            next();
+    }
+}
+
+void json_reader::wrong_type(const char *expected) const
+{
+    throw runtime_error(std::string("Expected ") + expected + " in line "
+                        + std::to_string(sc.cur_line)
+                        + ", column " + std::to_string(sc.cur_col));
+}
+
+std::string_view json_reader::get_string_view() const
+{
+    if ((token != STRING_TK) && (token != KEY_TK))
+        wrong_type("a string");
+    return std::string_view(sc.token);
+}
+
+// Converts the current scalar like the json accessors do:
+static json scalar_value(const number_t &n)
+{
+    switch (n.type) {
+    case json::BOOL_T:
+        return json(n.uint_value != 0);
+    case json::SIGNED_T:
+        return json(n.int_value);
+    case json::UNSIGNED_T:
+        return json(n.uint_value);
+    default:
+        return json(n.real_value);
+    } // end switch //
+}
+
+bool json_reader::get_bool() const
+{
+    if ((token < BOOL_TK) || (token > REAL_TK))
+        wrong_type("a boolean");
+    return scalar_value(m.scalar()).toBool();
+}
+
+int64_t json_reader::get_int() const
+{
+    if ((token < BOOL_TK) || (token > REAL_TK))
+        wrong_type("a number");
+    return scalar_value(m.scalar()).toSigned();
+}
+
+uint64_t json_reader::get_uint() const
+{
+    if ((token < BOOL_TK) || (token > REAL_TK))
+        wrong_type("a number");
+    return scalar_value(m.scalar()).toUnsigned();
+}
+
+json_real_t json_reader::get_real() const
+{
+    if ((token < BOOL_TK) || (token > REAL_TK))
+        wrong_type("a number");
+    return scalar_value(m.scalar()).toReal();
+}
+
+} // end namespace jsonx //
@@ -0,0 +1,118 @@
+#ifndef JSON_READER_HPP
+#define JSON_READER_HPP
+
+#include "jsonx.hpp"
+#include "scanner.hpp"
+#include "number.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Pull parser: the caller advances through a document token by
+ *        token with next() and may stop at any point. Nothing is
+ *        materialized except the current token and one byte per open
+ *        object or array. Accepts the same input as json::parse().
+ *        Errors throw with the line and column, like json::parse().
+ */
+class json_reader
+{
+public:
+    typedef enum {
+        /*0*/  NONE_TK,         // Before the first next()
+        /*1*/  NULL_TK,
+        /*2*/  BOOL_TK,
+        /*3*/  SIGNED_TK,
+        /*4*/  UNSIGNED_TK,
+        /*5*/  REAL_TK,
+        /*6*/  STRING_TK,
+        /*7*/  KEY_TK,          // Always followed by the member's value
+        /*8*/  START_OBJECT_TK,
+        /*9*/  END_OBJECT_TK,
+        /*10*/ START_ARRAY_TK,
+        /*11*/ END_ARRAY_TK,
+        /*12*/ END_TK           // End of the document
+    } TokenType;
+
+    /**
+     * @brief The grammar of json::parse() as a sequence of tokens, read
+     *        from a scanner owned by the caller. The one implementation
+     *        behind json_reader and sax_parse().
+     */
+    class machine
+    {
+    public:
+        /**
+         * @brief Read the next token. Errors throw without the position.
+         *        The text of strings and keys is in sc.token.
+         */
+        TokenType step(scanner &sc);
+        // Value of NULL_TK, BOOL_TK and numbers:
+        const number_t &scalar() const { return number; }
+        size_t depth() const { return stack.size(); }
+
+    private:
+        std::vector<char> stack;          // Closing characters of the open containers
+        bool              value{true};    // A value starts at the current position
+        bool              item{false};    // An item ends at the current position
+        number_t          number;
+    }; // end class machine //
+
+    json_reader(const char *data, size_t size): sc(data, size) {}
+    json_reader(std::string_view s): sc(s) {}
+    json_reader(std::istream &is): sc(is) {}
+    json_reader(const json_reader&) = delete;
+    json_reader& operator=(const json_reader&) = delete;
+
+    /**
+     * @brief Advance to the next token.
+     * @return The new token type, END_TK once the document is complete.
+     */
+    TokenType next();
+    TokenType token_type() const { return token; }
+
+    /**
+     * @brief Skip the value starting at the current token: after KEY_TK
+     *        the member's value, after START_OBJECT_TK or START_ARRAY_TK
+     *        everything up to and including the matching end token.
+     *        Does nothing for other tokens.
+     */
+    void skip_value();
+
+    /**
+     * @brief Text of a STRING_TK or KEY_TK token, valid until next().
+     *        Throws for other tokens.
+     */
+    std::string_view get_string_view() const;
+    /**
+     * @brief Numbers are converted like json::toUnsigned() etc.
+     *        Throw for tokens that are not numbers (or BOOL_TK).
+     */
+    bool get_bool() const;
+    int64_t get_int() const;
+    uint64_t get_uint() const;
+    json_real_t get_real() const;
+
+    /**
+     * @brief Number of objects and arrays open at the current token.
+     */
+    size_t depth() const { return m.depth(); }
+    int line() const { return sc.cur_line; }
+    int column() const { return sc.cur_col; }
+
+private:
+    [[noreturn]] void wrong_type(const char *expected) const;
+
+    scanner   sc;
+    machine   m;
+    TokenType token{NONE_TK};
+}; // end class json_reader //
+
+} // end namespace jsonx //
+
+#endif // JSON_READER_HPP
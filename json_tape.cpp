@@ -0,0 +1,469 @@
+
+#include "json_tape.hpp"
+#include "mapped_file.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace jsonx {
+
+// File layout: tape_header, the words of the tape, the string pool.
+// A word holds the type in the upper 8 bits, flags in the next 8 bits
+// and a payload in the lower 48 bits:
+//   UNDEFINED_T, NULL_T   -
+//   BOOL_T                The value
+//   SIGNED_T, UNSIGNED_T, -, the next word holds the value
+//   REAL_T
+//   STRING_T              Offset of the string in the pool
+//   ARRAY_T               Number of items n, followed by n words with
+//                         the positions of the items
+//   OBJECT_T              Number of members n, followed by n pairs of
+//                         words with the pool offset of the key and the
+//                         position of the value
+// A string in the pool is its size as 64 bit word, the characters and a
+// NUL, padded to a multiple of 8 bytes.
+
+struct tape_header {
+    char     magic[8];
+    uint64_t order;     // Detects tapes of the other byte order
+    uint64_t words;
+    uint64_t pool_size;
+};
+
+static const char     tape_magic[8]{'J', 'S', 'O', 'N', 'X', 'T', 'P', '1'};
+static const uint64_t tape_order{0x0102030405060708};
+
+static const unsigned TYPE_SHIFT{56};
+static const uint64_t PAYLOAD_MASK{(uint64_t(1) << 48) - 1};
+// Object with the keys in ascending order:
+static const uint64_t SORTED_F{uint64_t(1) << 48};
+
+///////////////////////////////////////////////////////////////////////////////
+// Writer
+///////////////////////////////////////////////////////////////////////////////
+
+class tape_writer {
+public:
+    uint64_t put(const json &v);
+
+    std::vector<uint64_t> tape;
+    std::string           pool;
+
+private:
+    uint64_t add_string(std::string_view s);
+    uint64_t add_key(std::string_view s);
+
+    // Pool offsets of the keys, which refer to the tree being written:
+    std::unordered_map<std::string_view, uint64_t> keys;
+}; // end class tape_writer //
+
+static inline uint64_t tape_word(json::DataType type, uint64_t payload)
+{
+    if (payload > PAYLOAD_MASK)
+        throw runtime_error("Too large for the tape format");
+    return (static_cast<uint64_t>(type) << TYPE_SHIFT) | payload;
+}
+
+uint64_t tape_writer::add_string(std::string_view s)
+{
+    const uint64_t offset = pool.size();
+    const uint64_t size = s.size();
+    pool.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    pool.append(s.data(), s.size());
+    pool.append(8 - (s.size() % 8), '\0');
+    return offset;
+}
+
+uint64_t tape_writer::add_key(std::string_view s)
+{
+    auto iter = keys.find(s);
+    if (iter != keys.end())
+        return iter->second;
+    const uint64_t offset = add_string(s);
+    keys.emplace(s, offset);
+    return offset;
+}
+
+uint64_t tape_writer::put(const json &v)
+{
+    const uint64_t pos = tape.size();
+    const json::DataType type = v.getType();
+    switch (type) {
+    case json::UNDEFINED_T:
+    case json::NULL_T:
+        tape.push_back(tape_word(type, 0));
+        break;
+    case json::BOOL_T:
+        tape.push_back(tape_word(type, v.toBool()));
+        break;
+    case json::SIGNED_T:
+        tape.push_back(tape_word(type, 0));
+        tape.push_back(static_cast<uint64_t>(v.toSigned()));
+        break;
+    case json::UNSIGNED_T:
+        tape.push_back(tape_word(type, 0));
+        tape.push_back(v.toUnsigned());
+        break;
+    case json::REAL_T:
+        {
+            const json_real_t r = v.toReal();
+            uint64_t bits;
+            memcpy(&bits, &r, sizeof(bits));
+            tape.push_back(tape_word(type, 0));
+            tape.push_back(bits);
+        }
+        break;
+    case json::STRING_T:
+        tape.push_back(tape_word(type, 0));
+        tape[pos] |= add_string(v.toStringView());
+        break;
+    case json::ARRAY_T:
+        {
+            const json_array_t &a = v.toArray();
+            tape.push_back(tape_word(type, a.size()));
+            const size_t table = tape.size();
+            tape.resize(table + a.size());
+            for (size_t i = 0; i < a.size(); ++i) {
+                const uint64_t item = put(a[i]);
+                tape[table + i] = item;
+            }
+        }
+        break;
+    case json::OBJECT_T:
+        {
+            const size_t n = v.size();
+            tape.push_back(tape_word(type, n));
+            const size_t table = tape.size();
+            tape.resize(table + 2 * n);
+            size_t i{0};
+            bool sorted{true};
+            std::string_view last;
+            for (const json_object_value_t &item : v.toObject()) {
+                if (!item.second.isDefined())
+                    continue;
+                const std::string_view key(item.first);
+                if ((i > 0) && !(last < key))
+                    sorted = false;
+                last = key;
+                tape[table + 2 * i] = add_key(key);
+                const uint64_t value = put(item.second);
+                tape[table + 2 * i + 1] = value;
+                i += 1;
+            }
+            if (sorted)
+                tape[pos] |= SORTED_F;
+        }
+        break;
+    default:
+        throw runtime_error("Invalid data type " + std::to_string(type));
+    } // end switch //
+    return pos;
+}
+
+static tape_header make_header(const tape_writer &w)
+{
+    tape_header h;
+    memcpy(h.magic, tape_magic, sizeof(h.magic));
+    h.order = tape_order;
+    h.words = w.tape.size();
+    h.pool_size = w.pool.size();
+    return h;
+}
+
+void to_tape(const json &v, std::string &out)
+{
+    tape_writer w;
+    w.put(v);
+    const tape_header h = make_header(w);
+    out.clear();
+    out.reserve(sizeof(h) + w.tape.size() * sizeof(uint64_t) + w.pool.size());
+    out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.append(reinterpret_cast<const char*>(w.tape.data()), w.tape.size() * sizeof(uint64_t));
+    out.append(w.pool);
+}
+
+void to_tape(const json &v, std::ostream &os)
+{
+    tape_writer w;
+    w.put(v);
+    const tape_header h = make_header(w);
+    os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    os.write(reinterpret_cast<const char*>(w.tape.data()), w.tape.size() * sizeof(uint64_t));
+    os.write(w.pool.data(), w.pool.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// json_tape
+///////////////////////////////////////////////////////////////////////////////
+
+json_tape::json_tape()
+{
+}
+
+json_tape::~json_tape()
+{
+}
+
+void json_tape::open(const char *_data, size_t _size)
+{
+    file.reset();
+    buffer.clear();
+    data = _data;
+    size = _size;
+    check();
+}
+
+void json_tape::open(std::string &&s)
+{
+    file.reset();
+    buffer = std::move(s);
+    data = buffer.data();
+    size = buffer.size();
+    check();
+}
+
+void json_tape::open_file(const char *path)
+{
+    buffer.clear();
+    // Queries jump around, reading the whole file ahead would not help:
+    file = make_unique<mapped_file>(path, false);
+    data = file->data();
+    size = file->size();
+    check();
+}
+
+void json_tape::check()
+{
+    tape = nullptr;
+    words = pool_size = 0;
+    pool = nullptr;
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0)
+        throw runtime_error("Tape not aligned to 8 bytes");
+    tape_header h;
+    if (size < sizeof(h))
+        throw runtime_error("Not a tape");
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.magic, tape_magic, sizeof(h.magic)) != 0)
+        throw runtime_error("Not a tape");
+    if (h.order != tape_order)
+        throw runtime_error("Tape of a different byte order");
+    if ((h.words > (size - sizeof(h)) / sizeof(uint64_t))
+        || (h.pool_size != size - sizeof(h) - h.words * sizeof(uint64_t)))
+        throw runtime_error("Tape size does not match its header");
+    tape = reinterpret_cast<const uint64_t*>(data + sizeof(h));
+    words = h.words;
+    pool = data + sizeof(h) + words * sizeof(uint64_t);
+    pool_size = h.pool_size;
+}
+
+void json_tape::fail() const
+{
+    throw runtime_error("Damaged tape");
+}
+
+uint64_t json_tape::word(uint64_t pos) const
+{
+    if (pos >= words)
+        fail();
+    return tape[pos];
+}
+
+std::string_view json_tape::string_at(uint64_t offset) const
+{
+    uint64_t n;
+    if ((offset > pool_size) || (pool_size - offset < sizeof(n)))
+        fail();
+    memcpy(&n, pool + offset, sizeof(n));
+    if (pool_size - offset - sizeof(n) <= n)
+        fail();
+    return std::string_view(pool + offset + sizeof(n), static_cast<size_t>(n));
+}
+
+const json_tape_value json_tape::root() const
+{
+    return json_tape_value(this, words ? 0 : json_tape_value::NONE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// json_tape_value
+///////////////////////////////////////////////////////////////////////////////
+
+json::DataType json_tape_value::getType() const
+{
+    if (pos == NONE)
+        return json::UNDEFINED_T;
+    const uint64_t type = tape->word(pos) >> TYPE_SHIFT;
+    if (type > json::OBJECT_T)
+        tape->fail();
+    return static_cast<json::DataType>(type);
+}
+
+size_t json_tape_value::size() const
+{
+    switch (getType()) {
+    case json::UNDEFINED_T:
+        return 0;
+    case json::ARRAY_T:
+    case json::OBJECT_T:
+        return static_cast<size_t>(tape->word(pos) & PAYLOAD_MASK);
+    default:
+        return 1;
+    } // end switch //
+}
+
+const json_tape_value json_tape_value::at(size_t i) const
+{
+    uint64_t child;
+    switch (getType()) {
+    case json::ARRAY_T:
+        if (i >= size())
+            return json_tape_value();
+        child = tape->word(pos + 1 + i);
+        break;
+    case json::OBJECT_T:
+        if (i >= size())
+            return json_tape_value();
+        child = tape->word(pos + 2 + 2 * i);
+        break;
+    default:
+        return json_tape_value();
+    } // end switch //
+    // Children follow their parent, a damaged tape cannot loop:
+    if (child <= pos)
+        tape->fail();
+    return json_tape_value(tape, child);
+}
+
+std::string_view json_tape_value::key(size_t i) const
+{
+    if (!isObject() || (i >= size()))
+        return std::string_view();
+    return tape->string_at(tape->word(pos + 1 + 2 * i));
+}
+
+const json_tape_value json_tape_value::find(std::string_view k) const
+{
+    if (!isObject())
+        return json_tape_value();
+    const size_t n = size();
+    if (tape->word(pos) & SORTED_F) {
+        size_t first{0}, last{n};
+        while (first < last) {
+            const size_t middle = first + (last - first) / 2;
+            const int c = key(middle).compare(k);
+            if (c == 0)
+                return at(middle);
+            if (c < 0)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            if (key(i) == k)
+                return at(i);
+        }
+    }
+    return json_tape_value();
+}
+
+std::string_view json_tape_value::toStringView() const
+{
+    if (!isString())
+        return std::string_view();
+    return tape->string_at(tape->word(pos) & PAYLOAD_MASK);
+}
+
+const char *json_tape_value::c_str() const
+{
+    // The pool keeps a NUL behind every string:
+    if (!isString())
+        return "";
+    return toStringView().data();
+}
+
+bool json_tape_value::toBool() const
+{
+    if (isArray() || isObject())
+        return size() != 0;
+    return scalar().toBool();
+}
+
+int64_t json_tape_value::toSigned() const
+{
+    if (isArray() || isObject())
+        return size();
+    return scalar().toSigned();
+}
+
+uint64_t json_tape_value::toUnsigned() const
+{
+    if (isArray() || isObject())
+        return size();
+    return scalar().toUnsigned();
+}
+
+json_real_t json_tape_value::toReal() const
+{
+    if (isArray() || isObject())
+        return static_cast<json_real_t>(size());
+    return scalar().toReal();
+}
+
+json json_tape_value::scalar() const
+{
+    switch (getType()) {
+    case json::NULL_T:
+        return json(json::NULL_T);
+    case json::BOOL_T:
+        return json((tape->word(pos) & PAYLOAD_MASK) != 0);
+    case json::SIGNED_T:
+        return json(static_cast<int64_t>(tape->word(pos + 1)));
+    case json::UNSIGNED_T:
+        return json(tape->word(pos + 1));
+    case json::REAL_T:
+        {
+            const uint64_t bits = tape->word(pos + 1);
+            json_real_t r;
+            memcpy(&r, &bits, sizeof(r));
+            return json(r);
+        }
+    case json::STRING_T:
+        return json(std::string(toStringView()));
+    default:
+        return json();
+    } // end switch //
+}
+
+json json_tape_value::toJson() const
+{
+    switch (getType()) {
+    case json::ARRAY_T:
+        {
+            // Undefined items are kept, unlike with json::add():
+            json v;
+            v.initArray(nullptr);
+            const size_t n = size();
+            v.array_value->reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                v.array_value->push_back(at(i).toJson());
+            return v;
+        }
+    case json::OBJECT_T:
+        {
+            json v(json::OBJECT_T);
+            const size_t n = size();
+            for (size_t i = 0; i < n; ++i)
+                v.add(std::string(key(i)), at(i).toJson());
+            return v;
+        }
+    default:
+        return scalar();
+    } // end switch //
+}
+
+} // end namespace jsonx //
@@ -0,0 +1,167 @@
+#ifndef JSON_TAPE_HPP
+#define JSON_TAPE_HPP
+
+#include "jsonx.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace jsonx {
+
+class json_tape;
+class mapped_file;
+
+/**
+ * @brief Write v in the tape format, the binary form read by json_tape.
+ *        The tape is a flat array of 64 bit words followed by a pool of
+ *        strings. Every value is a word with its type; numbers take a
+ *        second word, strings refer to the pool and arrays and objects are
+ *        followed by the positions of their items, and the offsets of the
+ *        keys, so they are found without visiting the values in between.
+ *        All references are relative, the tape can be stored and mapped at
+ *        any address. Keys are stored once, undefined members are left
+ *        out. The byte order is that of the writer.
+ *        out is replaced, a tape must start at an address divisible by 8.
+ */
+void to_tape(const json &v, std::string &out);
+inline std::string to_tape(const json &v)
+{
+    std::string s;
+    to_tape(v, s);
+    return s;
+}
+void to_tape(const json &v, std::ostream &os);
+
+/**
+ * @brief Read-only view of a value on a json_tape.
+ *        Holds a position only and reads the tape in place, strings are
+ *        not copied by toStringView() and c_str(). Views are invalidated
+ *        by opening another tape in the json_tape or destroying it.
+ *        Conversions follow the rules of the json class.
+ */
+class json_tape_value {
+public:
+    json_tape_value() {}
+
+    json::DataType getType() const;
+    bool isDefined() const { return getType() != json::UNDEFINED_T; }
+    bool isNull() const { return getType() == json::NULL_T; }
+    bool isString() const { return getType() == json::STRING_T; }
+    bool isArray() const { return getType() == json::ARRAY_T; }
+    bool isObject() const { return getType() == json::OBJECT_T; }
+
+    /**
+     * @brief Number of items or members, like json::size().
+     */
+    size_t size() const;
+
+    /**
+     * @brief Item i of an array, or the value of member i of an object.
+     */
+    const json_tape_value at(size_t i) const;
+    const json_tape_value operator[] (json_index_t i) const {
+        return at(static_cast<size_t>(i));
+    }
+    /**
+     * @brief Key of member i of an object, empty for other values.
+     */
+    std::string_view key(size_t i) const;
+    /**
+     * @brief Member key, undefined if missing. A binary search if the
+     *        keys were written in order, as from sorted containers.
+     */
+    const json_tape_value find(std::string_view key) const;
+    const json_tape_value operator[] (const char *key) const {
+        return find(key);
+    }
+    const json_tape_value operator[] (const std::string &key) const {
+        return find(key);
+    }
+
+    // Arrays and objects convert to their size() without being built:
+    bool toBool() const;
+    int64_t toSigned() const;
+    uint64_t toUnsigned() const;
+    int toInt() const { return static_cast<int>(toSigned()); }
+    json_real_t toReal() const;
+    // Empty for values that are no strings, like json::toString() const:
+    json_string_t toString() const { return json_string_t(toStringView()); }
+    std::string_view toStringView() const;
+    const char *c_str() const;
+
+    /**
+     * @brief Build this value, including all children, as a json tree.
+     */
+    json toJson() const;
+
+private:
+    friend class json_tape;
+
+    static const uint64_t NONE{UINT64_MAX};
+
+    json_tape_value(const json_tape *_tape, uint64_t _pos): tape{_tape}, pos{_pos} {}
+    // Value of a scalar or string, undefined for arrays and objects:
+    json scalar() const;
+
+    const json_tape *tape{nullptr};
+    uint64_t         pos{NONE};  // Word of the value
+}; // end class json_tape_value //
+
+/**
+ * @brief Tape written by to_tape(), queried in place. Opening checks the
+ *        header only, nothing is converted or copied, so a tape file is
+ *        ready as soon as it is mapped and its pages are shared by all
+ *        processes that map it. Access is checked against the bounds of
+ *        the tape, a damaged tape throws instead of reading past it.
+ *        Data passed to open() is not copied and must outlive the tape,
+ *        unless it is moved in as a std::string.
+ */
+class json_tape {
+public:
+    json_tape();
+    json_tape(const json_tape&) = delete;
+    json_tape& operator=(const json_tape&) = delete;
+    ~json_tape();
+
+    // IO:
+    void open(const char *data, size_t size);
+    void open(std::string &&s);
+    void open_file(const char *path);
+
+    // Access:
+    const json_tape_value root() const;
+    const json_tape_value operator[] (json_index_t i) const {
+        return root()[i];
+    }
+    const json_tape_value operator[] (const char *key) const {
+        return root()[key];
+    }
+    const json_tape_value operator[] (const std::string &key) const {
+        return root()[key];
+    }
+
+private:
+    friend class json_tape_value;
+
+    void check();
+    uint64_t word(uint64_t pos) const;
+    std::string_view string_at(uint64_t offset) const;
+    [[noreturn]] void fail() const;
+
+    const uint64_t              *tape{nullptr};
+    uint64_t                     words{0};
+    const char                  *pool{nullptr};
+    uint64_t                     pool_size{0};
+    const char                  *data{nullptr};
+    size_t                       size{0};
+    std::string                  buffer;
+    std::unique_ptr<mapped_file> file;
+}; // end class json_tape //
+
+} // end namespace jsonx //
+
+#endif // JSON_TAPE_HPP
@@ -1,15 +1,95 @@
 #include "jsonx.hpp"
 #include "io.hpp"
+#include "number.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstring>
 #include <cmath>
+#include <limits>
 #include <sstream>
 
 using namespace std;
 
 namespace jsonx {
 
+#ifdef JSONX_VIRTUAL_DESTRUCTOR
+static_assert(sizeof(json) <= 24, "Short strings must not enlarge the node");
+#else
+static_assert(sizeof(json) == 16, "Node layout is 8 bytes of value, 6 spare bytes, flags and type");
+#endif
+
+// Heap payloads are preceded by a reference count, so copies of a value
+// share them until one of the copies is modified (copy-on-write):
+struct refcount_t {
+    atomic<size_t> refs;
+};
+
+static const size_t REFCOUNT_SIZE{sizeof(refcount_t)};
+
+// Set in refs once a non-const reference into the payload was handed out.
+// Copies do not share such a payload, so the reference keeps referring to
+// the value it was taken from:
+static const size_t UNSHAREABLE{size_t(1) << (numeric_limits<size_t>::digits - 1)};
+
+template <class T>
+static refcount_t &refcount(T *v)
+{
+    return *reinterpret_cast<refcount_t*>(reinterpret_cast<char*>(v) - REFCOUNT_SIZE);
+}
+
+template <class T, class... Args>
+static T *new_shared(Args&&... args)
+{
+    static_assert(alignof(T) <= REFCOUNT_SIZE);
+    char *p = static_cast<char*>(::operator new(REFCOUNT_SIZE + sizeof(T)));
+    new (p) refcount_t{1};
+    try {
+        return new (p + REFCOUNT_SIZE) T(std::forward<Args>(args)...);
+    }
+    catch (...) {
+        ::operator delete(p);
+        throw;
+    }
+}
+
+template <class T>
+static T *acquire(T *v)
+{
+    refcount(v).refs.fetch_add(1, memory_order_relaxed);
+    return v;
+}
+
+template <class T>
+static void release(T *v)
+{
+    if ((refcount(v).refs.fetch_sub(1, memory_order_acq_rel) & ~UNSHAREABLE) == 1) {
+        v->~T();
+        ::operator delete(reinterpret_cast<char*>(v) - REFCOUNT_SIZE);
+    }
+}
+
+template <class T>
+static bool is_shared(T *v)
+{
+    return (refcount(v).refs.load(memory_order_acquire) & ~UNSHAREABLE) > 1;
+}
+
+template <class T>
+static bool is_shareable(T *v)
+{
+    return !(refcount(v).refs.load(memory_order_relaxed) & UNSHAREABLE);
+}
+
+template <class T>
+static void set_unshareable(T *v)
+{
+    // Only the first reference pays for the atomic operation:
+    if (is_shareable(v))
+        refcount(v).refs.fetch_or(UNSHAREABLE, memory_order_relaxed);
+}
+
 const json           json::undefined(json::UNDEFINED_T);
 const json           json::null(json::NULL_T);
 const json_array_t   json::empty_array{};
@@ -18,7 +98,8 @@ const std::string    json::empty_string{};
 
 json jarray(initializer_list<json> args)
 {
-    json rg(json::empty_array);
+    json rg(json::ARRAY_T);
+    rg.array_value->reserve(args.size());
     for_each(args.begin(), args.end(), [&rg](const json& j) {
         rg.add(j);
     });
@@ -27,7 +108,7 @@ json jarray(initializer_list<json> args)
 
 json jobject(initializer_list<json_object_value_t> args)
 {
-    json obj(json::empty_object);
+    json obj(json::OBJECT_T);
     for_each(args.begin(), args.end(), [&obj](const json_object_value_t& v) {
         obj.add(v.first, v.second);
     });
@@ -39,53 +120,22 @@ json::json(DataType t)
     type = t;
     switch (type) {
     case STRING_T:
-        string_value = new string();
+        copyFrom(string_view());
         break;
     case ARRAY_T:
-        array_value = new json_array_t();
+        array_value = new_shared<json_array_t>();
         break;
     case OBJECT_T:
-        object_value = new json_object_t();
+        object_value = new_shared<json_object_t>();
         break;
     default:
         break;
     } // end switch //
 }
 
-json::json(json&& rhs)
+json::json(json&& rhs) noexcept
 {
-    if (this == &rhs)
-        return;
-    swap(type, rhs.type);
-    switch (type) {
-    case UNDEFINED_T:
-        break;
-    case NULL_T:
-        break;
-    case BOOL_T:
-        bool_value = rhs.bool_value;
-        break;
-    case SIGNED_T:
-        int_value = rhs.int_value;
-        break;
-    case UNSIGNED_T:
-        uint_value = rhs.uint_value;
-        break;
-    case REAL_T:
-        real_value = rhs.real_value;
-        break;
-    case STRING_T:
-        swap(string_value, rhs.string_value);
-        break;
-    case ARRAY_T:
-        swap(array_value, rhs.array_value);
-        break;
-    case OBJECT_T:
-        swap(object_value, rhs.object_value);
-        break;
-    default:
-        cerr << "jsonx::json: Invalid data type " << type << endl;
-    } // end switch //
+    moveFrom(rhs);
 }
 
 json::~json()
@@ -126,18 +176,139 @@ void json::clear()
     case REAL_T:
         break;
     case STRING_T:
-        delete string_value;
+        if (!(flags & (ARENA_F | SHORT_F)))
+            release(string_value);
         break;
     case ARRAY_T:
-        delete array_value;
+        if (!(flags & ARENA_F))
+            release(array_value);
         break;
     case OBJECT_T:
-        delete object_value;
+        if (!(flags & ARENA_F))
+            release(object_value);
         break;
     default:
         cerr << "jsonx::json: Invalid data type " << type << endl;
     } // end switch //
+    // Arena payloads are released together with their arena.
     type = UNDEFINED_T;
+    flags = 0;
+}
+
+void json::initArray(std::pmr::memory_resource *arena)
+{
+    clear();
+    type = ARRAY_T;
+    if (arena) {
+        void *p = arena->allocate(sizeof(json_array_t), alignof(json_array_t));
+        array_value = new (p) json_array_t(arena);
+        flags |= ARENA_F;
+    } else {
+        array_value = new_shared<json_array_t>();
+    }
+}
+
+void json::initObject(std::pmr::memory_resource *arena)
+{
+    clear();
+    type = OBJECT_T;
+    if (arena) {
+        void *p = arena->allocate(sizeof(json_object_t), alignof(json_object_t));
+        object_value = new (p) json_object_t(arena);
+        flags |= ARENA_F;
+    } else {
+        object_value = new_shared<json_object_t>();
+    }
+}
+
+void json::detach()
+{
+    // Arena payloads are not shared, short strings are values.
+    if (flags & (ARENA_F | SHORT_F))
+        return;
+    switch (type) {
+    case STRING_T:
+        if (is_shared(string_value)) {
+            string *p = new_shared<string>(*string_value);
+            release(string_value);
+            string_value = p;
+        }
+        break;
+    case ARRAY_T:
+        if (is_shared(array_value)) {
+            json_array_t *p = new_shared<json_array_t>(*array_value);
+            release(array_value);
+            array_value = p;
+        }
+        break;
+    case OBJECT_T:
+        if (is_shared(object_value)) {
+            json_object_t *p = new_shared<json_object_t>(*object_value);
+            release(object_value);
+            object_value = p;
+        }
+        break;
+    default:
+        break;
+    } // end switch //
+}
+
+void json::unshare()
+{
+    detach();
+    if (flags & (ARENA_F | SHORT_F))
+        return;
+    switch (type) {
+    case STRING_T:
+        set_unshareable(string_value);
+        break;
+    case ARRAY_T:
+        set_unshareable(array_value);
+        break;
+    case OBJECT_T:
+        set_unshareable(object_value);
+        break;
+    default:
+        break;
+    } // end switch //
+}
+
+void json::initString(std::string_view s, std::pmr::memory_resource *arena)
+{
+    clear();
+    if (!arena || (s.size() <= SHORT_SIZE)) {
+        copyFrom(s);
+    } else {
+        type = STRING_T;
+        void *p = arena->allocate(offsetof(chars_t, data) + s.size() + 1,
+                                  alignof(chars_t));
+        chars_value = static_cast<chars_t*>(p);
+        chars_value->size = s.size();
+        memcpy(chars_value->data, s.data(), s.size());
+        chars_value->data[s.size()] = '\0';
+        flags |= ARENA_F;
+    }
+}
+
+json& json::initMember(std::string_view key)
+{
+    // Duplicate keys: the last one wins.
+    auto iter = object_value->find(key);
+    if (iter == object_value->end())
+        iter = object_value->emplace(key, undefined).first;
+    else
+        iter->second.clear();
+    return iter->second;
+}
+
+void json::operator=(json&& v) noexcept
+{
+    if (this == &v)
+        return;
+    // v may be a part of this value:
+    json tmp(std::move(v));
+    clear();
+    moveFrom(tmp);
 }
 
 void json::setNull()
@@ -146,6 +317,17 @@ void json::setNull()
     type = NULL_T;
 }
 
+void json::set(const char *v)
+{
+    // Reuse the string buffer, unless it is shared with copies:
+    if ((type == STRING_T) && !(flags & (ARENA_F | SHORT_F)) && !is_shared(string_value)) {
+        *string_value = v;
+    } else {
+        clear();
+        copyFrom(v);
+    }
+}
+
 void json::copyFrom(const json& v)
 {
     type = v.type;
@@ -166,13 +348,25 @@ void json::copyFrom(const json& v)
         real_value = v.toReal();
         break;
     case STRING_T:
-        copyFrom(v.string_value->c_str());
+        if (v.flags & (ARENA_F | SHORT_F))
+            copyFrom(v.toStringView());
+        else if (!is_shareable(v.string_value))
+            string_value = new_shared<string>(*v.string_value);
+        else
+            string_value = acquire(v.string_value);
         break;
     case ARRAY_T:
-        copyFrom(v.toArray());
+        // Arena payloads die with their arena and must be copied:
+        if ((v.flags & ARENA_F) || !is_shareable(v.array_value))
+            copyFrom(v.toArray());
+        else
+            array_value = acquire(v.array_value);
         break;
     case OBJECT_T:
-        copyFrom(v.toObject());
+        if ((v.flags & ARENA_F) || !is_shareable(v.object_value))
+            copyFrom(v.toObject());
+        else
+            object_value = acquire(v.object_value);
         break;
     default:
         cerr << "jsonx::json: Invalid data type " << type << endl;
@@ -204,15 +398,38 @@ void json::copyFrom(json_real_t v)
 }
 
 void json::copyFrom(const char *v)
+{
+    copyFrom(string_view(v));
+}
+
+void json::copyFrom(std::string_view v)
 {
     type = STRING_T;
-    string_value = new string(v);
+    if (v.size() <= SHORT_SIZE) {
+        char *p = shortData();
+        v.copy(p, v.size());
+        p[v.size()] = '\0';
+        flags |= SHORT_F | (v.size() << SHORT_SHIFT);
+    } else {
+        string_value = new_shared<string>(v);
+    }
+}
+
+void json::copyFrom(std::string &&v)
+{
+    if (v.size() <= SHORT_SIZE) {
+        copyFrom(string_view(v));
+    } else {
+        type = STRING_T;
+        string_value = new_shared<string>(std::move(v));
+    }
 }
 
 void json::copyFrom(const json_array_t& v)
 {
     type = ARRAY_T;
-    array_value = new json_array_t();
+    array_value = new_shared<json_array_t>();
+    array_value->reserve(v.size());
     for_each(v.begin(), v.end(), [this](const json& j) {
         array_value->push_back(json(j));
     });
@@ -221,12 +438,38 @@ void json::copyFrom(const json_array_t& v)
 void json::copyFrom(const json_object_t& v)
 {
     type = OBJECT_T;
-    object_value = new json_object_t();
+    object_value = new_shared<json_object_t>();
     for_each(v.begin(), v.end(), [this](const json_object_value_t& p) {
         object_value->emplace(p.first, p.second);
     });
 }
 
+void json::copyFrom(const std::vector<json>& v)
+{
+    type = ARRAY_T;
+    array_value = new_shared<json_array_t>(v.begin(), v.end());
+}
+
+void json::copyFrom(const std::map<std::string, json>& v)
+{
+    type = OBJECT_T;
+    object_value = new_shared<json_object_t>();
+    for_each(v.begin(), v.end(), [this](const std::pair<const std::string, json>& p) {
+        object_value->emplace(p.first, p.second);
+    });
+}
+
+void json::moveFrom(json& v) noexcept
+{
+    // This is undefined. Values, owned pointers and short strings
+    // all move bitwise, v is left undefined.
+    type = v.type;
+    flags = v.flags;
+    memcpy(shortData(), v.shortData(), SHORT_SIZE + 1);
+    v.type = UNDEFINED_T;
+    v.flags = 0;
+}
+
 bool& json::toBoolRef()
 {
     if (type != BOOL_T)
@@ -250,7 +493,7 @@ bool json::toBool() const
     case REAL_T:
         return round(real_value) != 0;
     case STRING_T:
-        return stoi(*string_value) != 0;
+        return stoi(toString()) != 0;
     case ARRAY_T:
         return !array_value->empty();
     case OBJECT_T:
@@ -299,7 +542,7 @@ int64_t json::toSigned() const
     case REAL_T:
         return static_cast<int64_t>(round(real_value));
     case STRING_T:
-        return stoi(*string_value);
+        return stoi(toString());
     case ARRAY_T:
         return array_value->size();
     case OBJECT_T:
@@ -354,7 +597,7 @@ uint64_t json::toUnsigned() const
         else
             return 0;
     case STRING_T:
-        return stoi(*string_value);
+        return stoi(toString());
     case ARRAY_T:
         return array_value->size();
     case OBJECT_T:
@@ -388,7 +631,7 @@ json_real_t json::toReal() const
     case REAL_T:
         return real_value;
     case STRING_T:
-        return static_cast<json_real_t>(stoi(*string_value));
+        return static_cast<json_real_t>(stoi(toString()));
     case ARRAY_T:
         return static_cast<json_real_t>(array_value->size());
     case OBJECT_T:
@@ -402,7 +645,7 @@ json_real_t json::toReal() const
 std::string json::toString() const
 {
     if (type == STRING_T)
-        return *string_value;
+        return string(toStringView());
     else
         return empty_string;
 }
@@ -421,9 +664,16 @@ std::string json::toString()
     case UNSIGNED_T:
         return to_string(uint_value);
     case REAL_T:
+    {
+#ifdef JSONX_LEGACY_REAL_FORMAT
         return to_string(real_value);
+#else
+        char s[real_size];
+        return string(s, format_real(s, real_value));
+#endif
+    }
     case STRING_T:
-        return *string_value;
+        return string(toStringView());
     case ARRAY_T:
     case OBJECT_T:
     default:
@@ -434,19 +684,44 @@ std::string json::toString()
 
 std::string& json::toStringRef()
 {
-    if (type != STRING_T) {
-        set(toString());
+    if ((type != STRING_T) || (flags & (ARENA_F | SHORT_F))) {
+        // A reference needs a std::string on the heap:
+        string *s = new_shared<string>(toString());
+        clear();
+        type = STRING_T;
+        string_value = s;
     }
+    unshare();
     return *string_value;
 }
 
-const std::string& json::toStringRef() const
+std::string_view json::toStringRef() const
 {
-    if (type != STRING_T) {
-        return empty_string;
-    } else {
+    return toStringView();
+}
+
+std::string_view json::toStringView() const
+{
+    if (type != STRING_T)
+        return string_view();
+    else if (flags & SHORT_F)
+        return string_view(shortData(), shortSize());
+    else if (flags & ARENA_F)
+        return string_view(chars_value->data, chars_value->size);
+    else
         return *string_value;
-    }
+}
+
+const char *json::c_str() const
+{
+    if (type != STRING_T)
+        return empty_string.c_str();
+    else if (flags & SHORT_F)
+        return shortData();
+    else if (flags & ARENA_F)
+        return chars_value->data;
+    else
+        return string_value->c_str();
 }
 
 const json_array_t& json::toArray() const
@@ -478,7 +753,7 @@ json_array_t json::toArray()
         j.push_back(json(real_value));
         break;
     case STRING_T:
-        j.push_back(json(string_value->c_str()));
+        j.push_back(json(toString()));
         break;
     case ARRAY_T:
         for_each(array_value->begin(), array_value->end(),
@@ -500,9 +775,9 @@ json_array_t json::toArray()
 
 json_array_t& json::toArrayRef()
 {
-    if (type != ARRAY_T) {
+    if (type != ARRAY_T)
         set(toArray());
-    }
+    unshare();
     return *array_value;
 }
 
@@ -544,7 +819,7 @@ json_object_t json::toObject()
         m.emplace("0", json(real_value));
         break;
     case STRING_T:
-        m.emplace("0", json(string_value->c_str()));
+        m.emplace("0", json(toString()));
         break;
     case ARRAY_T:
         for_each(array_value->begin(), array_value->end(),
@@ -566,15 +841,15 @@ json_object_t json::toObject()
 
 json_object_t& json::toObjectRef()
 {
-    if (type == OBJECT_T) {
+    if (type != OBJECT_T)
         set(toObject());
-    }
+    unshare();
     return *object_value;
 }
 
 const json_object_t& json::toObjectRef() const
 {
-    if (type == OBJECT_T) {
+    if (type != OBJECT_T) {
         throw runtime_error("Not an object");
     }
     return *object_value;
@@ -587,6 +862,7 @@ json& json::at(size_t i)
         for (size_t j = 0; j < i; ++j)
             (*array_value)[j].setUndefined();
     } else {
+        detach();
         while(i >= array_value->size())
             array_value->push_back(undefined);
     }
@@ -607,6 +883,7 @@ json& json::find(const char *key)
         set(toObject());
         iter = object_value->end();
     } else {
+        detach();
         iter = object_value->find(key);
     }
     if (iter == object_value->end())
@@ -625,27 +902,47 @@ const json& json::find(const char *key) const
 }
 
 void json::add(const json &j)
+{
+    add(json(j));
+}
+
+void json::add(json &&j)
 {
     if (type != ARRAY_T) {
-        clear();
-        array_value = new json_array_t();
-        type = ARRAY_T;
+        // j may be a part of this value:
+        json tmp(std::move(j));
+        initArray(nullptr);
+        if (tmp.isDefined())
+            array_value->push_back(std::move(tmp));
+    } else if (j.isDefined()) {
+        // j may be a part of this value:
+        json tmp(std::move(j));
+        detach();
+        array_value->push_back(std::move(tmp));
     }
-    if (j.isDefined())
-        array_value->push_back(j);
 }
 
 void json::add(const string &key, const json &j)
 {
-    if (type != OBJECT_T) {
-        clear();
-        object_value = new json_object_t();
-        type = OBJECT_T;
-    }
-    auto iter = object_value->find(key);
-    if (iter != object_value->end())
-        object_value->erase(iter);
-    object_value->emplace(key, j);
+    add(key, json(j));
+}
+
+void json::add(const string &key, json &&j)
+{
+    // j may be a part of this value:
+    json tmp(std::move(j));
+    setMember(key, tmp);
+}
+
+json& json::setMember(std::string_view key, json &v)
+{
+    if (type != OBJECT_T)
+        initObject(nullptr);
+    else
+        detach();
+    json &slot = initMember(key);
+    slot.moveFrom(v);
+    return slot;
 }
 
 bool json::operator==(const json &v) const
@@ -666,7 +963,7 @@ bool json::operator==(const json &v) const
     case REAL_T:
         return (real_value == v.real_value);
     case STRING_T:
-        return (*string_value == *v.string_value);
+        return (toStringView() == v.toStringView());
     case ARRAY_T:
         return operator==(*v.array_value);
     case OBJECT_T:
@@ -694,7 +991,7 @@ bool json::operator==(const json_object_t &v) const
         return false;
     auto result_iter = find_if_not(object_value->begin(), object_value->end(),
                                    [&v](const json_object_value_t &left) {
-        const string& left_key = left.first;
+        const json_key_t& left_key = left.first;
         const json& left_val = left.second;
         if (left_val.isDefined()) {
             auto iter = v.find(left_key);
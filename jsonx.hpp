@@ -4,10 +4,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory_resource>
 #include <iostream>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
 #include <stdint.h>
 
+#include "json_key.hpp"
+#include "flat_map.hpp"
+#include "ordered_map.hpp"
+
 /**
  * @brief Namespace for JsonX.
  *        Insert "using namespace jsonx" into your source code to automatically resolve names.
@@ -22,18 +29,65 @@ class json;
  * @brief Using std::string for string values.
  */
 typedef std::string json_string_t;
+#if defined(JSONX_INTERNED_KEYS)
+/**
+ * @brief Using handles to a global pool for object keys.
+ */
+typedef json_key json_key_t;
+#else
+/**
+ * @brief Object key: a std::pmr::string, so a json_document can place keys
+ *        in its arena. Converts to std::string, which object keys were
+ *        before json_document: "std::string s = item.first;" still works.
+ */
+class json_pmr_key: public std::pmr::string
+{
+public:
+    using std::pmr::string::basic_string;
+    using std::pmr::string::operator=;
+
+    operator std::string() const {
+        return std::string(data(), size());
+    }
+}; // end class json_pmr_key //
+typedef json_pmr_key json_key_t;
+#endif
 /**
- * @brief Using std::vector for json arrays.
+ * @brief Using std::pmr::vector for json arrays.
+ *        Polymorphic allocators let a json_document place arrays in its arena.
+ *        Note: json_array_t and json_object_t are no longer std::vector and
+ *        std::map. Values convert from those with the constructors below,
+ *        code naming the container types must use the typedefs.
+ */
+typedef std::pmr::vector<json> json_array_t;
+#if defined(JSONX_FLAT_OBJECTS)
+/**
+ * @brief Using a sorted vector for json objects.
+ */
+typedef flat_map<json_key_t, json> json_object_t;
+/**
+ * @brief Using std::pair for items in json objects.
+ */
+typedef std::pair<json_key_t, json> json_object_value_t;
+#elif defined(JSONX_ORDERED_OBJECTS)
+/**
+ * @brief Using a hashed vector in insertion order for json objects.
+ */
+typedef ordered_map<json_key_t, json> json_object_t;
+/**
+ * @brief Using std::pair for items in json objects.
  */
-typedef std::vector<json> json_array_t;
+typedef std::pair<json_key_t, json> json_object_value_t;
+#else
 /**
- * @brief Using std::map for json objects.
+ * @brief Using std::pmr::map for json objects.
  */
-typedef std::map<const std::string, json> json_object_t;
+typedef std::pmr::map<const json_key_t, json, std::less<>> json_object_t;
 /**
  * @brief Using std::pair for items in json objects.
  */
-typedef std::pair<const std::string, json> json_object_value_t;
+typedef std::pair<const json_key_t, json> json_object_value_t;
+#endif
 /**
  * @brief Using int as index values in [] expressions.
  *        Note: Using size_t breaks todays compilers for lots of ambiguities.
@@ -48,10 +102,26 @@ typedef double                             json_real_t;
 /**
  * @brief Main json class.
  *        Simply use "json" as type for every json node in your program.
+ *        Copies share their string, array and object payloads and are O(1).
+ *        A shared payload is copied on the first non-const access to it
+ *        (toArrayRef(), toObjectRef(), toStringRef(), at(), find(), add()).
+ *        toArrayRef(), toObjectRef() and the non-const toStringRef() hand
+ *        out a reference to the payload itself. From then on copies of
+ *        this value copy the payload instead of sharing it, in O(n), so
+ *        the reference still modifies this value only. Assigning another
+ *        value drops the mark with the old payload and makes copies O(1)
+ *        again, except a string assigned to a string, which keeps its
+ *        buffer for the reference.
+ *        Lookups (at(), find(), operator[], emplace(), emplaceBack()) do
+ *        not mark the payload: a json& they return refers to an element
+ *        of the payload that copies taken afterwards share, so finish
+ *        writing through it before copying the value. Likewise, a const
+ *        reference taken before a copy may refer to the payload kept by
+ *        the copy once this value is modified.
  */
 class json {
 public:
-    typedef enum {
+    typedef enum : uint8_t {
         /*0*/ UNDEFINED_T,
         /*1*/ NULL_T,
         /*2*/ BOOL_T,
@@ -63,6 +133,16 @@ public:
         /*8*/ OBJECT_T
     } DataType;
 
+    typedef enum {
+        /*0*/ SCANNER_E, // Recursive descent over the character scanner
+        /*1*/ INDEX_E,   // Two-stage: structural index, then tree
+        /*2*/ PARALLEL_E // Items of a top-level array on the shared thread
+                         // pool, other documents as SCANNER_E. Falls back
+                         // to SCANNER_E when called from a task of the
+                         // shared pool, where waiting for the workers
+                         // could deadlock.
+    } ParseEngine;
+
     // Constants:
     static const json           undefined;
     static const json           null;
@@ -74,11 +154,17 @@ public:
     json() {}
     json(DataType t);
     json(const json& rhs): json() { copyFrom(rhs); }
-    json(json&& rhs);
+    json(json&& rhs) noexcept;
     json(const json_array_t& rhs): json() { copyFrom(rhs); }
     json(const json_object_t& rhs): json() { copyFrom(rhs); }
+    // Containers with the default allocator, as before json_document.
+    // Templates, so braced lists still construct json_array_t:
+    template <class V> requires std::is_same_v<V, std::vector<json>>
+    json(const V& rhs): json() { copyFrom(rhs); }
+    template <class M> requires std::is_same_v<M, std::map<std::string, json>>
+    json(const M& rhs): json() { copyFrom(rhs); }
     json(const char *rhs): json() { copyFrom(rhs); }
-    json(const std::string& rhs): json() { copyFrom(rhs.c_str()); }
+    json(const std::string& rhs): json() { copyFrom(std::string_view(rhs)); }
     json(bool rhs): json() { copyFrom(rhs); }
     json(int64_t rhs): json() { copyFrom(rhs); }
     json(int8_t rhs): json(static_cast<int64_t>(rhs)) {}
@@ -92,7 +178,13 @@ public:
     json(double rhs): json() { copyFrom(static_cast<json_real_t>(rhs)); }
 
     // Destructor:
+    // Not virtual unless JSONX_VIRTUAL_DESTRUCTOR is defined, which makes
+    // every node 8 bytes larger. Do not delete derived classes through json*.
+#ifdef JSONX_VIRTUAL_DESTRUCTOR
     virtual ~json();
+#else
+    ~json();
+#endif
 
     // Operations:
     void clear();
@@ -101,15 +193,40 @@ public:
     // IO:
     void write(std::ostream &os) const;
     json_string_t write() const {
-        std::ostringstream os;
-        write(os);
-        return os.str();
-    }
+        json_string_t s;
+        write_to(s);
+        return s;
+    }
+    /**
+     * @brief Append the serialized value to s, without going through
+     *        a std::ostream.
+     */
+    void write_to(std::string &s) const;
+    /**
+     * @brief Serialize into [data, data + size), not NUL terminated.
+     *        Throws if the buffer is too small.
+     * @return Number of bytes written.
+     */
+    size_t write_to(char *data, size_t size) const;
+    /**
+     * @brief Serialize like write(), with large arrays and objects split
+     *        into chunks that are written on the shared thread pool.
+     *        The output is the same as that of write(). Writes on the
+     *        calling thread, like write(), when called from a task of the
+     *        shared pool, where waiting for the workers could deadlock.
+     *        The string is appended to.
+     */
+    void write_parallel(std::ostream &os) const;
+    void write_parallel(std::string &s) const;
     void parse(std::istream &is);
-    void parse(const json_string_t &s) {
-        std::istringstream is(s);
-        parse(is);
+    void parse(const char *data, size_t size, ParseEngine engine = SCANNER_E);
+    void parse(std::string_view s, ParseEngine engine = SCANNER_E) {
+        parse(s.data(), s.size(), engine);
+    }
+    void parse(const char *s, ParseEngine engine) {
+        parse(std::string_view(s), engine);
     }
+    void parse_file(const char *path, ParseEngine engine = SCANNER_E);
 
     // Type checks:
     bool isDefined() const {
@@ -169,7 +286,17 @@ public:
     }
     json_string_t toString() const;
     json_string_t toString();
-    const json_string_t& toStringRef() const;
+    std::string_view toStringView() const;
+    /**
+     * @brief Same as toStringView(). Const access never changes the node,
+     *        and short strings and strings of a json_document have no
+     *        std::string to refer to. Valid until the value is modified.
+     */
+    std::string_view toStringRef() const;
+    /**
+     * @brief Moves short strings and strings of a json_document to a
+     *        std::string on the heap, only call it to modify the string.
+     */
     json_string_t& toStringRef();
     const json_array_t& toArray() const;
     json_array_t toArray();
@@ -179,9 +306,7 @@ public:
     json_object_t toObject();
     const json_object_t& toObjectRef() const;
     json_object_t& toObjectRef();
-    const char *c_str() const {
-        return toStringRef().c_str();
-    }
+    const char *c_str() const;
 
     // Automatic type conversations:
     operator bool() const {
@@ -247,10 +372,17 @@ public:
     operator json_real_t&() {
         return toRealRef();
     }
-    operator const json_string_t&() const {
-        return toStringRef();
+    // Reading a string copies it, only binding a non-const reference moves
+    // it out of the node, as toStringRef() does. The reference conversion
+    // is a template, so const references and copies do not select it:
+    operator json_string_t() const {
+        return json_string_t(toStringView());
     }
-    operator json_string_t&() {
+    operator json_string_t() {
+        return json_string_t(toStringView());
+    }
+    template <class S> requires std::is_same_v<S, json_string_t>
+    operator S&() {
         return toStringRef();
     }
 
@@ -260,8 +392,10 @@ public:
     }
     void setNull();
     void set(const json& v) {
+        // Copies are cheap, and v may be a part of this value:
+        json tmp(v);
         clear();
-        copyFrom(v);
+        moveFrom(tmp);
     }
     void set(bool v) {
         clear();
@@ -310,14 +444,7 @@ public:
     void set(const json_string_t& v) {
         set(v.c_str());
     }
-    void set(const char *v) {
-        if (type == STRING_T) {
-            *string_value = v;
-        } else {
-            clear();
-            copyFrom(v);
-        }
-    }
+    void set(const char *v);
     void set(const json_array_t& v) {
         clear();
         copyFrom(v);
@@ -329,6 +456,7 @@ public:
 
     // Assignments:
     void operator=(const json& v)          { set(v); }
+    void operator=(json&& v) noexcept;
     void operator=(bool v)                 { set(v); }
     void operator=(int8_t v)               { set(v); }
     void operator=(uint8_t v)              { set(v); }
@@ -372,6 +500,7 @@ public:
 
     // JSON array:
     void add(const json &j);
+    void add(json &&j);
     void addUndefined()              { add(undefined); }
     void addNull()                   { add(null);      }
     void add(bool v)                 { add(json(v));   }
@@ -393,9 +522,29 @@ public:
     void add(const char *v)          { add(json(v));   }
     void add(const json_array_t& v)  { add(json(v));   }
     void add(const json_object_t& v) { add(json(v));   }
+    /**
+     * @brief Append an element constructed in place from args.
+     *        Unlike add() the element is appended even if it is undefined,
+     *        so it can be filled in through the returned reference.
+     */
+    template <class... Args>
+    json& emplaceBack(Args&&... args) {
+        json v(std::forward<Args>(args)...);
+        if (type != ARRAY_T)
+            initArray(nullptr);
+        else
+            detach();
+        return array_value->emplace_back(std::move(v));
+    }
 
     // JSON object:
     void add(const std::string &key, const json &j);
+    void add(const std::string &key, json &&j);
+    // A template only for json rvalues, so scalars still use the overloads below:
+    template <class J> requires std::is_same_v<J, json>
+    void add(std::string &&key, J &&j) {
+        add(static_cast<const std::string&>(key), std::move(j));
+    }
     void addUndefined(const std::string &key) {
         add(key, undefined);
     }
@@ -447,6 +596,14 @@ public:
     void add(const std::string &key, const json_object_t& v) {
         add(key, json(v));
     }
+    /**
+     * @brief Set member key to a value constructed from args.
+     */
+    template <class... Args>
+    json& emplace(std::string_view key, Args&&... args) {
+        json v(std::forward<Args>(args)...);
+        return setMember(key, v);
+    }
 
     // Subscriptions:
     const json& at(size_t i) const;
@@ -483,13 +640,47 @@ private:
     void copyFrom(uint64_t v);
     void copyFrom(json_real_t v);
     void copyFrom(const char *v);
+    void copyFrom(std::string_view v);
+    void copyFrom(std::string &&v);
     void copyFrom(const json_array_t& v);
     void copyFrom(const json_object_t& v);
+    void copyFrom(const std::vector<json>& v);
+    void copyFrom(const std::map<std::string, json>& v);
+    void moveFrom(json& v) noexcept;
+    void detach();
+    // Detach, and copy the payload on later copies instead of sharing it,
+    // because a non-const reference into it is handed out:
+    void unshare();
+
+    void initArray(std::pmr::memory_resource *arena);
+    void initObject(std::pmr::memory_resource *arena);
+    void initString(std::string_view s, std::pmr::memory_resource *arena);
+    json& initMember(std::string_view key);
+    // Move v into member key, v must not be a part of this value:
+    json& setMember(std::string_view key, json &v);
 
     void parse(scanner &sc);
+    void parseDocument(scanner &sc);
+    void parseIndexed(const char *data, size_t size,
+                      std::pmr::memory_resource *arena);
+    // Parse the value at idx[0], using the structural index entries
+    // [idx, idx + n) of data:
+    void parseIndexed(const char *data, size_t size,
+                      const uint32_t *idx, size_t n,
+                      std::pmr::memory_resource *arena);
+    void parseParallel(const char *data, size_t size);
+    static void parseItems(const char *data, size_t size, std::vector<json> &items);
+    bool parseScalar(std::string_view s);
 
     friend class json_ref;
     friend class json_const;
+    friend class json_document;
+    friend class json_push_parser;
+    friend class cbor_decoder;
+    friend class msgpack_decoder;
+    friend class json_tape_value;
+    friend class json_lazy_value;
+    friend json jarray(std::initializer_list<json> v);
 
     friend std::ostream &operator<<(std::ostream &os, const json &j)
     {
@@ -503,7 +694,32 @@ private:
         return is;
     }
 
-    DataType type{UNDEFINED_T};
+    // Flags:
+    static const uint8_t ARENA_F{0x01}; // Node is part of an arena tree,
+                                        // its payload is owned by the arena
+    static const uint8_t SHORT_F{0x02}; // String is stored in the node
+    static const int     SHORT_SHIFT{4}; // Upper bits: Length of a short string
+
+    // Longest string stored in the node, the NUL follows:
+    static const size_t SHORT_SIZE{13};
+
+    // String payload in an arena:
+    struct chars_t {
+        size_t size;
+        char   data[1]; // size + 1 bytes, NUL terminated
+    };
+
+    // Short strings occupy the union and the spare bytes behind it:
+    char *shortData() {
+        return reinterpret_cast<char*>(&uint_value);
+    }
+    const char *shortData() const {
+        return reinterpret_cast<const char*>(&uint_value);
+    }
+    size_t shortSize() const {
+        return flags >> SHORT_SHIFT;
+    }
+
     union {
         bool            bool_value;
         uint64_t        uint_value;
@@ -512,19 +728,103 @@ private:
         json_string_t  *string_value;
         json_array_t   *array_value;
         json_object_t  *object_value;
+        chars_t        *chars_value;
     };
+    char     short_tail[SHORT_SIZE + 1 - sizeof(uint64_t)];
+    uint8_t  flags{0};
+    DataType type{UNDEFINED_T};
 }; // end class json //
 
+/**
+ * @brief Parsed json document that keeps all nodes, strings and containers
+ *        in a monotonic arena. Destroying or resetting the document releases
+ *        the whole tree at once, without visiting the nodes.
+ *        The tree is read-only. Copies taken from it are ordinary json values.
+ *        Strings are read in place through toStringView(), c_str() and the
+ *        const toStringRef(), a std::string is always a copy.
+ */
+class json_document {
+public:
+    explicit json_document(size_t initial_size = 64 * 1024);
+    json_document(const json_document&) = delete;
+    json_document& operator=(const json_document&) = delete;
+    ~json_document();
+
+    // IO:
+    void parse(std::istream &is);
+    void parse(const char *data, size_t size,
+               json::ParseEngine engine = json::SCANNER_E);
+    void parse(std::string_view s, json::ParseEngine engine = json::SCANNER_E) {
+        parse(s.data(), s.size(), engine);
+    }
+    void parse(const char *s, json::ParseEngine engine) {
+        parse(std::string_view(s), engine);
+    }
+    void parse_file(const char *path, json::ParseEngine engine = json::SCANNER_E);
+
+    // Release all nodes:
+    void reset();
+
+    // Access:
+    const json& root() const {
+        return value;
+    }
+    operator const json&() const {
+        return value;
+    }
+    const json& operator[] (json_index_t i) const {
+        return value[i];
+    }
+    const json& operator[] (const char *key) const {
+        return value[key];
+    }
+    const json& operator[] (const std::string& key) const {
+        return value[key];
+    }
+
+private:
+    friend class msgpack_decoder;
+
+    std::pmr::monotonic_buffer_resource arena;
+    json value;
+}; // end class json_document //
+
 // Json object value helper:
 inline json_object_value_t jitem(const char *key, const json& val)
 {
     return json_object_value_t(key, val);
 }
+inline json_object_value_t jitem(const char *key, json&& val)
+{
+    return json_object_value_t(key, std::move(val));
+}
 
 json jarray(std::initializer_list<json> v);
 
 json jobject(std::initializer_list<json_object_value_t> v);
 
+/**
+ * @brief Variadic forms of jarray() and jobject(). Unlike the elements of
+ *        an initializer list, the arguments are moved into the result, so
+ *        nested builders do not copy their subtrees.
+ *        Example: jarray(1, "two", jobject(jitem("three", 3)))
+ */
+template <class... Args>
+json jarray(Args&&... args)
+{
+    json rg(json::ARRAY_T);
+    (rg.add(std::forward<Args>(args)), ...);
+    return rg;
+}
+
+template <class... Args>
+json jobject(Args&&... args)
+{
+    json obj(json::OBJECT_T);
+    (obj.add(args.first, std::forward<Args>(args).second), ...);
+    return obj;
+}
+
 } // end namespace jsonx //
 
 #endif // JSONX_HPP
@@ -0,0 +1,86 @@
+#include "mapped_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace jsonx {
+
+static runtime_error file_error(const char *path)
+{
+    return runtime_error(string("Cannot read file \"") + path + "\": "
+                         + strerror(errno));
+}
+
+#ifndef _WIN32
+
+mapped_file::mapped_file(const char *path, bool sequential)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        throw file_error(path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto ex = file_error(path);
+        ::close(fd);
+        throw ex;
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            auto ex = file_error(path);
+            ::close(fd);
+            throw ex;
+        }
+        if (sequential) {
+            ::madvise(p, length, MADV_SEQUENTIAL);
+            ::madvise(p, length, MADV_WILLNEED);
+        } else {
+            ::madvise(p, length, MADV_RANDOM);
+        }
+        addr = static_cast<const char*>(p);
+    } else {
+        addr = buffer.data();
+    }
+    ::close(fd);
+}
+
+mapped_file::~mapped_file()
+{
+    if (length > 0)
+        ::munmap(const_cast<char*>(addr), length);
+}
+
+#else
+
+mapped_file::mapped_file(const char *path, bool)
+{
+    ifstream ifs(path, ios::binary);
+    if (!ifs)
+        throw file_error(path);
+    ostringstream os;
+    os << ifs.rdbuf();
+    buffer = os.str();
+    addr = buffer.data();
+    length = buffer.size();
+}
+
+mapped_file::~mapped_file()
+{
+}
+
+#endif
+
+} // end namespace jsonx //
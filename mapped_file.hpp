@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace jsonx {
+
+/**
+ * @brief Read-only view of a whole file.
+ *        Uses mmap() with sequential access hints where available,
+ *        otherwise reads the file into memory.
+ */
+class mapped_file
+{
+public:
+    // sequential: the data is read front to back, else at random places
+    explicit mapped_file(const char *path, bool sequential = true);
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
+
+    const char *data() const { return addr; }
+    size_t size() const { return length; }
+
+private:
+    const char *addr{nullptr};
+    size_t      length{0};
+    std::string buffer;
+};
+
+} // end namespace jsonx //
+
+#endif // MAPPED_FILE_HPP
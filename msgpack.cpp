@@ -0,0 +1,406 @@
+
+#include "msgpack.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace jsonx {
+
+// Formats:
+static const uint8_t MP_FIXMAP{0x80};
+static const uint8_t MP_FIXARRAY{0x90};
+static const uint8_t MP_FIXSTR{0xa0};
+static const uint8_t MP_NIL{0xc0};
+static const uint8_t MP_FALSE{0xc2};
+static const uint8_t MP_TRUE{0xc3};
+static const uint8_t MP_BIN8{0xc4};
+static const uint8_t MP_BIN16{0xc5};
+static const uint8_t MP_BIN32{0xc6};
+static const uint8_t MP_FLOAT32{0xca};
+static const uint8_t MP_FLOAT64{0xcb};
+static const uint8_t MP_UINT8{0xcc};
+static const uint8_t MP_UINT16{0xcd};
+static const uint8_t MP_UINT32{0xce};
+static const uint8_t MP_UINT64{0xcf};
+static const uint8_t MP_INT8{0xd0};
+static const uint8_t MP_INT16{0xd1};
+static const uint8_t MP_INT32{0xd2};
+static const uint8_t MP_INT64{0xd3};
+static const uint8_t MP_STR8{0xd9};
+static const uint8_t MP_STR16{0xda};
+static const uint8_t MP_STR32{0xdb};
+static const uint8_t MP_ARRAY16{0xdc};
+static const uint8_t MP_ARRAY32{0xdd};
+static const uint8_t MP_MAP16{0xde};
+static const uint8_t MP_MAP32{0xdf};
+static const uint8_t MP_NEGATIVE_FIXINT{0xe0};
+
+///////////////////////////////////////////////////////////////////////////////
+// Encoder
+///////////////////////////////////////////////////////////////////////////////
+
+// Format byte followed by the size lower bytes of n, big endian:
+static void put_format(std::string &out, uint8_t format, uint64_t n, size_t size)
+{
+    char b[9];
+    b[0] = static_cast<char>(format);
+    for (size_t i = size; i > 0; --i, n >>= 8)
+        b[i] = static_cast<char>(n & 0xff);
+    out.append(b, size + 1);
+}
+
+static void put_unsigned(std::string &out, uint64_t n)
+{
+    if (n < 0x80)
+        out.push_back(static_cast<char>(n));
+    else if (n <= 0xff)
+        put_format(out, MP_UINT8, n, 1);
+    else if (n <= 0xffff)
+        put_format(out, MP_UINT16, n, 2);
+    else if (n <= 0xffffffff)
+        put_format(out, MP_UINT32, n, 4);
+    else
+        put_format(out, MP_UINT64, n, 8);
+}
+
+static void put_signed(std::string &out, int64_t n)
+{
+    if (n >= 0)
+        put_unsigned(out, static_cast<uint64_t>(n));
+    else if (n >= -32)
+        out.push_back(static_cast<char>(n));
+    else if (n >= numeric_limits<int8_t>::min())
+        put_format(out, MP_INT8, static_cast<uint64_t>(n), 1);
+    else if (n >= numeric_limits<int16_t>::min())
+        put_format(out, MP_INT16, static_cast<uint64_t>(n), 2);
+    else if (n >= numeric_limits<int32_t>::min())
+        put_format(out, MP_INT32, static_cast<uint64_t>(n), 4);
+    else
+        put_format(out, MP_INT64, static_cast<uint64_t>(n), 8);
+}
+
+static void put_real(std::string &out, json_real_t v)
+{
+    const float f = static_cast<float>(v);
+    if (static_cast<json_real_t>(f) == v) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        put_format(out, MP_FLOAT32, bits, 4);
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        put_format(out, MP_FLOAT64, bits, 8);
+    }
+}
+
+static void put_size(std::string &out, size_t n, uint8_t fix, size_t fix_max,
+                     uint8_t format8, uint8_t format16, uint8_t format32)
+{
+    if (n <= fix_max)
+        out.push_back(static_cast<char>(fix | n));
+    else if ((format8 != 0) && (n <= 0xff))
+        put_format(out, format8, n, 1);
+    else if (n <= 0xffff)
+        put_format(out, format16, n, 2);
+    else if (n <= 0xffffffff)
+        put_format(out, format32, n, 4);
+    else
+        throw runtime_error("Too large for MessagePack");
+}
+
+static void put_string(std::string &out, std::string_view s)
+{
+    put_size(out, s.size(), MP_FIXSTR, 31, MP_STR8, MP_STR16, MP_STR32);
+    out.append(s.data(), s.size());
+}
+
+void to_msgpack(const json &v, std::string &out)
+{
+    switch (v.getType()) {
+    case json::UNDEFINED_T:
+        break;
+    case json::NULL_T:
+        out.push_back(static_cast<char>(MP_NIL));
+        break;
+    case json::BOOL_T:
+        out.push_back(static_cast<char>(v.toBool() ? MP_TRUE : MP_FALSE));
+        break;
+    case json::SIGNED_T:
+        put_signed(out, v.toSigned());
+        break;
+    case json::UNSIGNED_T:
+        put_unsigned(out, v.toUnsigned());
+        break;
+    case json::REAL_T:
+        put_real(out, v.toReal());
+        break;
+    case json::STRING_T:
+        put_string(out, v.toStringView());
+        break;
+    case json::ARRAY_T:
+        {
+            const json_array_t &a = v.toArray();
+            const size_t n = std::count_if(a.begin(), a.end(),
+                                           [](const json &item) { return item.isDefined(); });
+            put_size(out, n, MP_FIXARRAY, 15, 0, MP_ARRAY16, MP_ARRAY32);
+            for (const json &item : a)
+                to_msgpack(item, out);
+        }
+        break;
+    case json::OBJECT_T:
+        {
+            const json_object_t &o = v.toObject();
+            put_size(out, v.size(), MP_FIXMAP, 15, 0, MP_MAP16, MP_MAP32);
+            for (const json_object_value_t &item : o) {
+                if (item.second.isDefined()) {
+                    put_string(out, item.first);
+                    to_msgpack(item.second, out);
+                }
+            }
+        }
+        break;
+    default:
+        throw runtime_error("Invalid data type " + std::to_string(v.getType()));
+    } // end switch //
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Decoder
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Builds the nodes directly, on the heap or in an arena.
+ */
+class msgpack_decoder {
+public:
+    msgpack_decoder(const char *data, size_t size, std::pmr::memory_resource *_arena):
+        first{reinterpret_cast<const uint8_t*>(data)}, p{first}, last{first + size},
+        arena{_arena} {}
+
+    void decode(json &v);
+    bool done() const { return p == last; }
+    [[noreturn]] void fail(const std::string &what) const;
+
+    static void decode(json_document &doc, const char *data, size_t size);
+
+private:
+    void need(uint64_t n) const
+    {
+        if (n > static_cast<uint64_t>(last - p))
+            fail("Premature end of data");
+    }
+    // Big endian number of size bytes:
+    uint64_t read(size_t size)
+    {
+        need(size);
+        uint64_t n{0};
+        for (size_t i = 0; i < size; ++i)
+            n = (n << 8) | *p++;
+        return n;
+    }
+    std::string_view read_string(size_t size)
+    {
+        need(size);
+        std::string_view s(reinterpret_cast<const char*>(p), size);
+        p += size;
+        return s;
+    }
+    // Length of a string, or 0 and false if b is no string format:
+    bool string_size(uint8_t b, size_t &size);
+    void decode_array(json &v, size_t n);
+    void decode_map(json &v, size_t n);
+
+    const uint8_t              *first;
+    const uint8_t              *p;
+    const uint8_t              *last;
+    std::pmr::memory_resource  *arena;
+}; // end class msgpack_decoder //
+
+void msgpack_decoder::fail(const std::string &what) const
+{
+    throw runtime_error("Invalid MessagePack: " + what + " at offset "
+                        + std::to_string(p - first));
+}
+
+bool msgpack_decoder::string_size(uint8_t b, size_t &size)
+{
+    if ((b & 0xe0) == MP_FIXSTR) {
+        size = b & 0x1f;
+        return true;
+    }
+    switch (b) {
+    case MP_STR8:
+    case MP_BIN8:
+        size = static_cast<size_t>(read(1));
+        return true;
+    case MP_STR16:
+    case MP_BIN16:
+        size = static_cast<size_t>(read(2));
+        return true;
+    case MP_STR32:
+    case MP_BIN32:
+        size = static_cast<size_t>(read(4));
+        return true;
+    default:
+        return false;
+    } // end switch //
+}
+
+void msgpack_decoder::decode_array(json &v, size_t n)
+{
+    v.initArray(arena);
+    // Every item takes a byte at least:
+    v.array_value->reserve(std::min<size_t>(n, last - p));
+    for (size_t i = 0; i < n; ++i)
+        decode(v.array_value->emplace_back());
+}
+
+void msgpack_decoder::decode_map(json &v, size_t n)
+{
+    v.initObject(arena);
+    for (size_t i = 0; i < n; ++i) {
+        need(1);
+        size_t size;
+        if (!string_size(*p++, size)) {
+            --p;
+            fail("Map key is not a string");
+        }
+        decode(v.initMember(read_string(size)));
+    }
+}
+
+void msgpack_decoder::decode(json &v)
+{
+    v.clear();
+    need(1);
+    const uint8_t b = *p++;
+    if (b < 0x80) {
+        v.copyFrom(static_cast<uint64_t>(b));
+        return;
+    }
+    if (b >= MP_NEGATIVE_FIXINT) {
+        v.copyFrom(static_cast<int64_t>(static_cast<int8_t>(b)));
+        return;
+    }
+    size_t size;
+    if (string_size(b, size)) {
+        v.initString(read_string(size), arena);
+        return;
+    }
+    if ((b & 0xf0) == MP_FIXMAP) {
+        decode_map(v, b & 0x0f);
+        return;
+    }
+    if ((b & 0xf0) == MP_FIXARRAY) {
+        decode_array(v, b & 0x0f);
+        return;
+    }
+    switch (b) {
+    case MP_NIL:
+        v.setNull();
+        break;
+    case MP_FALSE:
+        v.copyFrom(false);
+        break;
+    case MP_TRUE:
+        v.copyFrom(true);
+        break;
+    case MP_FLOAT32:
+        {
+            const uint32_t bits = static_cast<uint32_t>(read(4));
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            v.copyFrom(static_cast<json_real_t>(f));
+        }
+        break;
+    case MP_FLOAT64:
+        {
+            const uint64_t bits = read(8);
+            json_real_t r;
+            memcpy(&r, &bits, sizeof(r));
+            v.copyFrom(r);
+        }
+        break;
+    case MP_UINT8:
+        v.copyFrom(read(1));
+        break;
+    case MP_UINT16:
+        v.copyFrom(read(2));
+        break;
+    case MP_UINT32:
+        v.copyFrom(read(4));
+        break;
+    case MP_UINT64:
+        v.copyFrom(read(8));
+        break;
+    case MP_INT8:
+        v.copyFrom(static_cast<int64_t>(static_cast<int8_t>(read(1))));
+        break;
+    case MP_INT16:
+        v.copyFrom(static_cast<int64_t>(static_cast<int16_t>(read(2))));
+        break;
+    case MP_INT32:
+        v.copyFrom(static_cast<int64_t>(static_cast<int32_t>(read(4))));
+        break;
+    case MP_INT64:
+        v.copyFrom(static_cast<int64_t>(read(8)));
+        break;
+    case MP_ARRAY16:
+        decode_array(v, static_cast<size_t>(read(2)));
+        break;
+    case MP_ARRAY32:
+        decode_array(v, static_cast<size_t>(read(4)));
+        break;
+    case MP_MAP16:
+        decode_map(v, static_cast<size_t>(read(2)));
+        break;
+    case MP_MAP32:
+        decode_map(v, static_cast<size_t>(read(4)));
+        break;
+    default:
+        --p;
+        fail("Unsupported format");
+    } // end switch //
+}
+
+void msgpack_decoder::decode(json_document &doc, const char *data, size_t size)
+{
+    doc.reset();
+    if (size == 0)
+        return;
+    msgpack_decoder d(data, size, &doc.arena);
+    try {
+        d.decode(doc.value);
+        if (!d.done())
+            d.fail("Data behind the object");
+    }
+    catch (...) {
+        doc.reset();
+        throw;
+    }
+}
+
+json from_msgpack(const char *data, size_t size)
+{
+    json v;
+    if (size == 0)
+        return v;
+    msgpack_decoder d(data, size, nullptr);
+    d.decode(v);
+    if (!d.done())
+        d.fail("Data behind the object");
+    return v;
+}
+
+void from_msgpack(json_document &doc, const char *data, size_t size)
+{
+    msgpack_decoder::decode(doc, data, size);
+}
+
+} // end namespace jsonx //
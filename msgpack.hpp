@@ -0,0 +1,55 @@
+#ifndef MSGPACK_HPP
+#define MSGPACK_HPP
+
+#include "jsonx.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace jsonx {
+
+/**
+ * @brief Append the MessagePack encoding of v to out.
+ *        UNSIGNED_T and non-negative SIGNED_T values use the smallest of
+ *        positive fixint and uint8/16/32/64, negative SIGNED_T values the
+ *        smallest of negative fixint and int8/16/32/64. REAL_T is a float32
+ *        if that is exact, else a float64. Strings are fixstr or
+ *        str8/16/32. Undefined array items and members are left out, as
+ *        write() does, an undefined value encodes as nothing.
+ */
+void to_msgpack(const json &v, std::string &out);
+inline std::string to_msgpack(const json &v)
+{
+    std::string s;
+    to_msgpack(v, s);
+    return s;
+}
+
+/**
+ * @brief Decode the MessagePack object in [data, data + size), an empty
+ *        input to an undefined value. Unsigned formats decode as
+ *        UNSIGNED_T, signed ones as SIGNED_T, bin formats as strings.
+ *        Map keys must be strings, with duplicates the last one wins.
+ *        Extension types are not supported.
+ *        Throws with the offset on invalid or incomplete data and on
+ *        bytes behind the object.
+ */
+json from_msgpack(const char *data, size_t size);
+inline json from_msgpack(std::string_view s)
+{
+    return from_msgpack(s.data(), s.size());
+}
+
+/**
+ * @brief Decode into the arena of a document, replacing its tree.
+ */
+void from_msgpack(json_document &doc, const char *data, size_t size);
+inline void from_msgpack(json_document &doc, std::string_view s)
+{
+    from_msgpack(doc, s.data(), s.size());
+}
+
+} // end namespace jsonx //
+
+#endif // MSGPACK_HPP
@@ -0,0 +1,184 @@
+
+#include "ndjson.hpp"
+#include "thread_pool.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace jsonx {
+
+/**
+ * @brief Lines parsed by one task.
+ */
+struct ndjson_batch {
+    std::string        text;          // Owned input, for streams
+    const char        *data{nullptr};
+    size_t             size{0};
+    std::vector<json>  values;
+    size_t             lines{0};      // Lines in data
+    size_t             error_line{0}; // Line of error within data
+    std::string        error;
+    std::future<void>  done;
+};
+
+static bool is_blank(const char *first, const char *last)
+{
+    for (; first < last; ++first) {
+        if (!std::isspace(static_cast<unsigned char>(*first)))
+            return false;
+    }
+    return true;
+}
+
+static void parse_batch(ndjson_batch &b)
+{
+    const char *p = b.data;
+    const char *end = b.data + b.size;
+    while (p < end) {
+        const char *nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char *eol = nl ? nl : end;
+        b.lines += 1;
+        if (!is_blank(p, eol)) {
+            json v;
+            try {
+                v.parse(p, eol - p);
+            }
+            catch (const std::exception &ex) {
+                b.error_line = b.lines;
+                b.error = ex.what();
+                return;
+            }
+            if (v.isDefined())
+                b.values.push_back(std::move(v));
+        }
+        p = eol + 1;
+    }
+}
+
+ndjson_reader::ndjson_reader(size_t threads, size_t _batch_size):
+    own_pool{threads ? new thread_pool(threads) : nullptr},
+    pool{threads ? own_pool.get() : &thread_pool::shared()},
+    batch_size{std::max<size_t>(_batch_size, 1)}
+{
+}
+
+ndjson_reader::~ndjson_reader()
+{
+}
+
+void ndjson_reader::run(const std::function<bool(ndjson_batch&)> &next, const callback_t &f)
+{
+    // On a worker of the pool, waiting for tasks could take the workers
+    // they need, so the batches are parsed on this thread, one at a time:
+    const bool on_worker = pool->is_worker();
+    // Enough batches in flight to keep all workers busy while the
+    // values of the oldest one are delivered:
+    const size_t max_inflight = on_worker ? 1 : 2 * pool->size();
+    std::deque<std::unique_ptr<ndjson_batch>> inflight;
+    size_t line{0};
+    bool more{true};
+    try {
+        while (true) {
+            while (more && (inflight.size() < max_inflight)) {
+                unique_ptr<ndjson_batch> b(new ndjson_batch);
+                if (!next(*b)) {
+                    more = false;
+                    break;
+                }
+                ndjson_batch *p = b.get();
+                if (on_worker)
+                    parse_batch(*p);
+                else
+                    b->done = pool->submit([p]() { parse_batch(*p); });
+                inflight.push_back(std::move(b));
+            }
+            if (inflight.empty())
+                return;
+            ndjson_batch &b = *inflight.front();
+            if (b.done.valid())
+                b.done.get();
+            for (json &v : b.values)
+                f(std::move(v));
+            if (!b.error.empty()) {
+                throw runtime_error(b.error + " of the record in line "
+                                    + std::to_string(line + b.error_line));
+            }
+            line += b.lines;
+            inflight.pop_front();
+        }
+    }
+    catch (...) {
+        // The workers still use the batches:
+        for (auto &b : inflight) {
+            if (b->done.valid())
+                b->done.wait();
+        }
+        throw;
+    }
+}
+
+void ndjson_reader::parse(const char *data, size_t size, const callback_t &f)
+{
+    const char *p = data;
+    const char *end = data + size;
+    run([&](ndjson_batch &b) {
+        if (p >= end)
+            return false;
+        // Whole lines of about batch_size bytes:
+        const char *last = end;
+        if (static_cast<size_t>(end - p) > batch_size) {
+            last = static_cast<const char*>(memchr(p + batch_size, '\n', end - p - batch_size));
+            last = last ? last + 1 : end;
+        }
+        b.data = p;
+        b.size = last - p;
+        p = last;
+        return true;
+    }, f);
+}
+
+void ndjson_reader::parse(std::istream &is, const callback_t &f)
+{
+    std::string carry;
+    run([&](ndjson_batch &b) {
+        b.text.swap(carry);
+        carry.clear();
+        const size_t have = b.text.size();
+        b.text.resize(have + batch_size);
+        is.read(b.text.data() + have, batch_size);
+        b.text.resize(have + static_cast<size_t>(is.gcount()));
+        if (b.text.empty())
+            return false;
+        if (is) {
+            // Keep the incomplete last line for the next batch:
+            const size_t nl = b.text.rfind('\n');
+            if (nl != string::npos) {
+                carry.assign(b.text, nl + 1, string::npos);
+                b.text.resize(nl + 1);
+            } else {
+                carry.swap(b.text);
+                b.text.clear();
+            }
+        }
+        b.data = b.text.data();
+        b.size = b.text.size();
+        return true;
+    }, f);
+}
+
+void ndjson_reader::parse_file(const char *path, const callback_t &f)
+{
+    mapped_file file(path);
+    parse(file.data(), file.size(), f);
+}
+
+} // end namespace jsonx //
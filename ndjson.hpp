@@ -0,0 +1,59 @@
+#ifndef NDJSON_HPP
+#define NDJSON_HPP
+
+#include "jsonx.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+namespace jsonx {
+
+class thread_pool;
+struct ndjson_batch;
+
+/**
+ * @brief Reader for newline delimited json (NDJSON, JSON Lines).
+ *        Splits the input into batches of whole lines, parses the batches
+ *        on worker threads and passes the values to a callback on the
+ *        calling thread, in input order. Every line holds one record, blank
+ *        lines and lines with only a comment are skipped.
+ *        If a record fails to parse, the records before it are delivered,
+ *        then the error is thrown with the line number of the record.
+ *        Exceptions of the callback stop reading and are passed on.
+ */
+class ndjson_reader
+{
+public:
+    typedef std::function<void(json &&value)> callback_t;
+
+    /**
+     * @param threads Worker threads, 0 to use the shared pool. Called from
+     *        a task of that pool, parse() works on the calling thread.
+     * @param batch_size Approximate number of bytes parsed as one task.
+     */
+    explicit ndjson_reader(size_t threads = 0, size_t batch_size = 256 * 1024);
+    ndjson_reader(const ndjson_reader&) = delete;
+    ndjson_reader& operator=(const ndjson_reader&) = delete;
+    ~ndjson_reader();
+
+    void parse(const char *data, size_t size, const callback_t &f);
+    void parse(std::string_view s, const callback_t &f) {
+        parse(s.data(), s.size(), f);
+    }
+    void parse(std::istream &is, const callback_t &f);
+    void parse_file(const char *path, const callback_t &f);
+
+private:
+    void run(const std::function<bool(ndjson_batch&)> &next, const callback_t &f);
+
+    std::unique_ptr<thread_pool> own_pool;
+    thread_pool                 *pool;
+    size_t                       batch_size;
+}; // end class ndjson_reader //
+
+} // end namespace jsonx //
+
+#endif // NDJSON_HPP
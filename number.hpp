@@ -0,0 +1,121 @@
+#ifndef NUMBER_HPP
+#define NUMBER_HPP
+
+#include "jsonx.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+namespace jsonx {
+
+/**
+ * @brief Result of lex_number().
+ */
+struct number_t {
+    json::DataType type{json::UNDEFINED_T};
+    union {
+        int64_t     int_value;
+        uint64_t    uint_value;
+        json_real_t real_value;
+    };
+};
+
+/**
+ * @brief Recognize and convert a number token in a single pass.
+ *        Accepted forms are "123" (UNSIGNED_T), "+123" and "-123" (SIGNED_T)
+ *        and -?(0|[1-9]\d*)(\.\d+)?([eE][+-]?\d+)? (REAL_T).
+ *        Integers that do not fit into 64 bits are converted to REAL_T.
+ *        Locale independent, does not throw.
+ * @return false if [first, last) is not a number.
+ */
+inline bool lex_number(const char *first, const char *last, number_t &n) noexcept
+{
+    const char *p = first;
+    bool sign{false};
+    if ((p < last) && ((*p == '+') || (*p == '-'))) {
+        sign = true;
+        ++p;
+    }
+    const char *digits = p;
+    while ((p < last) && (static_cast<unsigned>(*p - '0') < 10))
+        ++p;
+    if (p == digits)
+        return false;
+    if (p == last) {
+        // Integer:
+        std::from_chars_result r;
+        if (!sign) {
+            n.type = json::UNSIGNED_T;
+            r = std::from_chars(digits, last, n.uint_value);
+        } else {
+            n.type = json::SIGNED_T;
+            r = std::from_chars((*first == '-') ? first : digits, last, n.int_value);
+        }
+        if (r.ec == std::errc())
+            return true;
+        // Out of range, fall back to real:
+        n.type = json::REAL_T;
+        r = std::from_chars((*first == '-') ? first : digits, last, n.real_value);
+        return (r.ec == std::errc());
+    }
+    // Real:
+    if ((sign && (*first == '+')) || ((p - digits > 1) && (*digits == '0')))
+        return false;
+    if (*p == '.') {
+        const char *fraction = ++p;
+        while ((p < last) && (static_cast<unsigned>(*p - '0') < 10))
+            ++p;
+        if (p == fraction)
+            return false;
+    }
+    if ((p < last) && ((*p == 'e') || (*p == 'E'))) {
+        ++p;
+        if ((p < last) && ((*p == '+') || (*p == '-')))
+            ++p;
+        const char *exponent = p;
+        while ((p < last) && (static_cast<unsigned>(*p - '0') < 10))
+            ++p;
+        if (p == exponent)
+            return false;
+    }
+    if (p != last)
+        return false;
+    n.type = json::REAL_T;
+    auto r = std::from_chars(first, last, n.real_value);
+    return (r.ec == std::errc()) && (r.ptr == last);
+}
+
+/**
+ * @brief Room format_real() needs for any value.
+ */
+const size_t real_size{32};
+
+/**
+ * @brief Format v into [first, first + real_size).
+ *        Writes the shortest representation that converts back to exactly
+ *        v, with ".0" appended to integral values, so they are parsed back
+ *        as REAL_T. With JSONX_LEGACY_REAL_FORMAT it uses 6 significant
+ *        digits like the default format of std::ostream.
+ * @return End of the characters written.
+ */
+inline char *format_real(char *first, json_real_t v) noexcept
+{
+#ifdef JSONX_LEGACY_REAL_FORMAT
+    return std::to_chars(first, first + real_size, v, std::chars_format::general, 6).ptr;
+#else
+    char *last = std::to_chars(first, first + real_size, v).ptr;
+    // Not for exponents, inf and nan:
+    if (std::find_if(first, last, [](char ch) {
+            return (ch == '.') || (ch == 'e') || (ch == 'i') || (ch == 'n');
+        }) == last) {
+        *last++ = '.';
+        *last++ = '0';
+    }
+    return last;
+#endif
+}
+
+} // end namespace jsonx //
+
+#endif // NUMBER_HPP
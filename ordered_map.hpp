@@ -0,0 +1,157 @@
+#ifndef ORDERED_MAP_HPP
+#define ORDERED_MAP_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Map with string keys that keeps its entries in insertion order.
+ *        The entries are stored densely in a vector, so iteration is a
+ *        linear walk. Once there are more than a few entries, an open
+ *        addressing hash table of entry numbers gives O(1) average lookups.
+ *        Erasing preserves the order and rebuilds the hash table.
+ *        Provides the subset of the std::map interface used for json objects.
+ */
+template <class Key, class T>
+class ordered_map
+{
+public:
+    typedef Key                                        key_type;
+    typedef T                                          mapped_type;
+    typedef std::pair<Key, T>                          value_type;
+    typedef std::pmr::vector<value_type>               container_type;
+    typedef typename container_type::allocator_type    allocator_type;
+    typedef typename container_type::iterator          iterator;
+    typedef typename container_type::const_iterator    const_iterator;
+    typedef size_t                                     size_type;
+
+    ordered_map() {}
+    ordered_map(const allocator_type &alloc): items(alloc), slots(alloc) {}
+
+    iterator begin() { return items.begin(); }
+    iterator end() { return items.end(); }
+    const_iterator begin() const { return items.begin(); }
+    const_iterator end() const { return items.end(); }
+
+    size_type size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    void clear() {
+        items.clear();
+        slots.clear();
+    }
+    void reserve(size_type n) { items.reserve(n); }
+
+    iterator find(std::string_view key) {
+        return items.begin() + search(key);
+    }
+    const_iterator find(std::string_view key) const {
+        return items.begin() + search(key);
+    }
+
+    /**
+     * @brief Like std::map::try_emplace(): Does nothing if key is present,
+     *        appends a new entry otherwise.
+     */
+    template <class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K &&key, Args&&... args) {
+        const std::string_view k(key);
+        const size_type i = search(k);
+        if (i != items.size())
+            return std::make_pair(items.begin() + i, false);
+        items.emplace_back(std::piecewise_construct,
+                           std::forward_as_tuple(std::forward<K>(key)),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+        if (!slots.empty() && (2 * items.size() <= slots.size()))
+            insert(i);
+        else if (items.size() > LINEAR_SIZE)
+            rehash();
+        return std::make_pair(items.begin() + i, true);
+    }
+
+    template <class K, class V>
+    std::pair<iterator, bool> emplace(K &&key, V &&value) {
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    iterator erase(const_iterator pos) {
+        const size_type i = pos - items.begin();
+        items.erase(pos);
+        if (!slots.empty())
+            rehash();
+        return items.begin() + i;
+    }
+    size_type erase(std::string_view key) {
+        const_iterator iter = find(key);
+        if (iter == items.end())
+            return 0;
+        erase(iter);
+        return 1;
+    }
+
+    T& operator[](std::string_view key) {
+        return try_emplace(key).first->second;
+    }
+
+private:
+    // Up to this size entries are searched linearly, without hash table:
+    static constexpr size_type LINEAR_SIZE{8};
+    static constexpr uint32_t  EMPTY{0};
+
+    static size_t hash(std::string_view key) {
+        return std::hash<std::string_view>()(key);
+    }
+
+    // Entry number of key, size() if not found:
+    size_type search(std::string_view key) const {
+        if (slots.empty()) {
+            for (size_type i = 0; i < items.size(); ++i) {
+                if (items[i].first == key)
+                    return i;
+            }
+            return items.size();
+        }
+        const size_t mask = slots.size() - 1;
+        for (size_t s = hash(key) & mask; slots[s] != EMPTY; s = (s + 1) & mask) {
+            const size_type i = slots[s] - 1;
+            if (items[i].first == key)
+                return i;
+        }
+        return items.size();
+    }
+
+    // Enter entry i into the hash table, which has a free slot:
+    void insert(size_type i) {
+        const size_t mask = slots.size() - 1;
+        size_t s = hash(items[i].first) & mask;
+        while (slots[s] != EMPTY)
+            s = (s + 1) & mask;
+        slots[s] = static_cast<uint32_t>(i + 1);
+    }
+
+    // Rebuild the hash table with a load factor of at most 1/2:
+    void rehash() {
+        slots.clear();
+        if (items.size() <= LINEAR_SIZE)
+            return;
+        size_t n{4 * LINEAR_SIZE};
+        while (n < 4 * items.size())
+            n *= 2;
+        slots.resize(n, EMPTY);
+        for (size_type i = 0; i < items.size(); ++i)
+            insert(i);
+    }
+
+    container_type             items;
+    std::pmr::vector<uint32_t> slots;
+}; // end class ordered_map //
+
+} // end namespace jsonx //
+
+#endif // ORDERED_MAP_HPP
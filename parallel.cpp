@@ -0,0 +1,370 @@
+
+#include "jsonx.hpp"
+#include "scanner.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+#include "writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace jsonx {
+
+// Smallest range of items parsed as one task:
+static const size_t min_chunk_size{16 * 1024};
+// Items or members written as one task:
+static const size_t chunk_items{4096};
+
+/**
+ * @brief Items of a top-level array parsed by one task.
+ */
+struct parse_chunk {
+    const char         *first{nullptr};
+    const char         *last{nullptr};
+    std::vector<json>   items;
+    std::future<void>   done;
+};
+
+/**
+ * @brief Split the items of the array starting behind its '[' at p into
+ *        ranges of about chunk_size bytes, cut at the commas between items.
+ *        Strings and comments are skipped, brackets are counted.
+ * @return false if the closing ']' was not found.
+ */
+static bool split_items(const char *p, const char *end, size_t chunk_size,
+                        std::vector<parse_chunk> &chunks)
+{
+    size_t depth{0};
+    const char *first = p;
+    while (p < end) {
+        switch (*p) {
+        case '"':
+            ++p;
+            while (true) {
+                if (p < end)
+                    p = find_string_special(p, end);
+                if (p >= end)
+                    return false;
+                if (*p == '"')
+                    break;
+                p += (*p == '\\') ? 2 : 1;
+            } // end while //
+            break;
+        case '/':
+            if ((p + 1 < end) && (p[1] == '/')) {
+                p = static_cast<const char*>(memchr(p, '\n', end - p));
+                if (!p)
+                    return false;
+            }
+            break;
+        case '[':
+        case '{':
+            ++depth;
+            break;
+        case ']':
+        case '}':
+            if (depth == 0) {
+                if (*p != ']')
+                    return false;
+                chunks.emplace_back();
+                chunks.back().first = first;
+                chunks.back().last = p;
+                return true;
+            }
+            --depth;
+            break;
+        case ',':
+            if ((depth == 0) && (static_cast<size_t>(p - first) >= chunk_size)) {
+                chunks.emplace_back();
+                chunks.back().first = first;
+                chunks.back().last = p;
+                first = p + 1;
+            }
+            break;
+        default:
+            break;
+        } // end switch //
+        ++p;
+    } // end while //
+    return false;
+}
+
+/**
+ * @brief Parse a range of items, as the array branch of json::parse() does.
+ *        A ']' or '}' at the top of the range means the split went wrong.
+ */
+void json::parseItems(const char *data, size_t size, std::vector<json> &items)
+{
+    scanner sc(data, size);
+    sc.skip_whitespace();
+    while (!sc.eof()) {
+        if ((sc.cur_ch == ']') || (sc.cur_ch == '}'))
+            throw runtime_error("Unexpected bracket");
+        items.emplace_back();
+        items.back().parse(sc);
+        if (!items.back().isDefined())
+            items.pop_back();
+        sc.skip_whitespace();
+        if (sc.cur_ch == ',') {
+            sc.get_ch();
+            sc.skip_whitespace();
+        }
+    } // end while //
+}
+
+void json::parseParallel(const char *data, size_t size)
+{
+    thread_pool &pool = thread_pool::shared();
+    scanner sc(data, size);
+    sc.skip_whitespace();
+    // Waiting for the chunks from a task of the pool could take the
+    // workers the chunks need:
+    if ((sc.cur_ch != '[') || pool.is_worker()) {
+        parse(data, size);
+        return;
+    }
+    const char *begin = sc.data() + 1;
+    const char *end = data + size;
+    const size_t chunk_size = std::max(min_chunk_size,
+                                       static_cast<size_t>(end - begin) / (4 * pool.size()));
+    std::vector<parse_chunk> chunks;
+    bool ok = split_items(begin, end, chunk_size, chunks);
+    if (ok) {
+        // Each task fills its own vector, so the workers allocate
+        // independently of each other:
+        for (parse_chunk &c : chunks) {
+            parse_chunk *p = &c;
+            c.done = pool.submit([p]() {
+                parseItems(p->first, p->last - p->first, p->items);
+            });
+        }
+        for (parse_chunk &c : chunks) {
+            try {
+                c.done.get();
+            }
+            catch (...) {
+                ok = false;
+            }
+        }
+    }
+    if (!ok) {
+        // Syntax error somewhere; the sequential parser reports it
+        // with the position in the whole input:
+        chunks.clear();
+        parse(data, size);
+        return;
+    }
+    size_t n{0};
+    for (const parse_chunk &c : chunks)
+        n += c.items.size();
+    clear();
+    initArray(nullptr);
+    array_value->reserve(n);
+    for (parse_chunk &c : chunks) {
+        for (json &v : c.items)
+            array_value->push_back(std::move(v));
+    }
+}
+
+/**
+ * @brief Piece of the output of json::write_parallel(), in output order.
+ */
+struct write_segment {
+    std::string        text;
+    std::future<void>  done;     // Valid for chunks written by a task
+    size_t             group{0}; // Object of a member chunk, 0 for none
+};
+
+/**
+ * @brief Walks the tree like writer::write() and hands chunks of the items
+ *        of large arrays and objects to the shared thread pool. Finished
+ *        segments are passed to the sink in order while the walk goes on,
+ *        so only a few chunks are held in memory at a time.
+ */
+class parallel_writer {
+public:
+    typedef std::function<void(std::string_view)> sink_t;
+
+    parallel_writer(const sink_t &_sink): pool{thread_pool::shared()}, sink{_sink}
+    {
+        open_segment();
+    }
+    parallel_writer(const parallel_writer&) = delete;
+    parallel_writer& operator=(const parallel_writer&) = delete;
+    // The tasks still use the segments after an exception:
+    ~parallel_writer()
+    {
+        for (write_segment &s : segments) {
+            if (s.done.valid())
+                s.done.wait();
+        }
+    }
+
+    void write(const json &v);
+
+    void finish()
+    {
+        w->finish();
+        w.reset();
+        emit(0, true);
+    }
+
+private:
+    void open_segment()
+    {
+        segments.emplace_back();
+        w.reset(new writer(segments.back().text));
+    }
+
+    void add_chunk(std::function<void(writer&)> f, size_t group);
+    // Pass on leading segments until at most max_pending chunks are left:
+    void emit(size_t max_pending, bool all = false);
+
+    thread_pool                &pool;
+    sink_t                      sink;
+    std::deque<write_segment>   segments;
+    std::unique_ptr<writer>     w;          // Writes the last segment
+    size_t                      pending{0}; // Chunks in segments
+    size_t                      groups{0};
+    // The first member chunk of an object with output drops its comma:
+    size_t                      emit_group{0};
+    bool                        emit_member{false};
+}; // end class parallel_writer //
+
+void parallel_writer::add_chunk(std::function<void(writer&)> f, size_t group)
+{
+    w->finish();
+    w.reset();
+    segments.emplace_back();
+    write_segment *s = &segments.back();
+    s->group = group;
+    s->done = pool.submit([s, f]() {
+        writer cw(s->text);
+        f(cw);
+        cw.finish();
+    });
+    pending += 1;
+    emit(2 * pool.size());
+    open_segment();
+}
+
+void parallel_writer::emit(size_t max_pending, bool all)
+{
+    while (!segments.empty() && ((pending > max_pending) || all)) {
+        write_segment &s = segments.front();
+        size_t skip{0};
+        if (s.done.valid()) {
+            s.done.get();
+            pending -= 1;
+            if (s.group != emit_group) {
+                emit_group = s.group;
+                emit_member = false;
+            }
+            if (!s.text.empty() && (s.group != 0)) {
+                skip = emit_member ? 0 : 1;
+                emit_member = true;
+            }
+        }
+        if (s.text.size() > skip)
+            sink(std::string_view(s.text).substr(skip));
+        segments.pop_front();
+    } // end while //
+}
+
+void parallel_writer::write(const json &v)
+{
+    switch (v.getType()) {
+    case json::ARRAY_T:
+        {
+            const json_array_t &a = v.toArray();
+            const json *first = a.data();
+            const json *last = first + a.size();
+            w->put('[');
+            if (a.size() > chunk_items) {
+                for (const json *p = first; p < last; p += chunk_items) {
+                    const json *q = p + std::min(chunk_items, static_cast<size_t>(last - p));
+                    if (p != first)
+                        w->put(',');
+                    add_chunk([p, q](writer &cw) { cw.write_items(p, q); }, 0);
+                }
+            } else {
+                for (const json *p = first; p != last; ++p) {
+                    if (p != first)
+                        w->put(',');
+                    write(*p);
+                }
+            }
+            w->put(']');
+        }
+        break;
+    case json::OBJECT_T:
+        {
+            const json_object_t &o = v.toObject();
+            w->put('{');
+            if (o.size() > chunk_items) {
+                const size_t group = ++groups;
+                auto p = o.begin();
+                while (p != o.end()) {
+                    auto q = p;
+                    for (size_t i = 0; (i < chunk_items) && (q != o.end()); ++i)
+                        ++q;
+                    add_chunk([p, q](writer &cw) { cw.write_members(p, q, true); }, group);
+                    p = q;
+                }
+            } else {
+                bool comma{false};
+                for (const json_object_value_t &item : o) {
+                    if (item.second.isDefined()) {
+                        if (comma)
+                            w->put(',');
+                        comma = true;
+                        w->write_string(item.first);
+                        w->put(':');
+                        write(item.second);
+                    }
+                }
+            }
+            w->put('}');
+        }
+        break;
+    default:
+        w->write(v);
+        break;
+    } // end switch //
+}
+
+void json::write_parallel(std::ostream &os) const
+{
+    // Waiting for the chunks from a task of the pool could take the
+    // workers the chunks need:
+    if (thread_pool::shared().is_worker()) {
+        write(os);
+        return;
+    }
+    parallel_writer pw([&os](std::string_view s) { os.write(s.data(), s.size()); });
+    pw.write(*this);
+    pw.finish();
+}
+
+void json::write_parallel(std::string &s) const
+{
+    if (thread_pool::shared().is_worker()) {
+        write_to(s);
+        return;
+    }
+    parallel_writer pw([&s](std::string_view t) { s.append(t); });
+    pw.write(*this);
+    pw.finish();
+}
+
+} // end namespace jsonx //
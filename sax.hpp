@@ -0,0 +1,129 @@
+#ifndef SAX_HPP
+#define SAX_HPP
+
+#include "jsonx.hpp"
+#include "scanner.hpp"
+#include "json_reader.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Handler for sax_parse() that ignores all events.
+ *        Derive from it and declare only the events you need; the calls
+ *        are resolved at compile time, no virtual functions are involved.
+ *        String views are valid during the call only.
+ */
+struct sax_handler {
+    void on_null() {}
+    void on_bool(bool) {}
+    void on_int(int64_t) {}
+    void on_uint(uint64_t) {}
+    void on_real(json_real_t) {}
+    void on_string(std::string_view) {}
+    void on_key(std::string_view) {}
+    void start_object() {}
+    void end_object() {}
+    void start_array() {}
+    void end_array() {}
+};
+
+/**
+ * @brief Parse one value from sc and report it to h as events, in the
+ *        order of the input, without building a tree.
+ *        Accepts the same input as json::parse(). Members and items
+ *        without a value are not reported.
+ *        The tokens come from json_reader::machine, so nesting is tracked
+ *        on a heap stack of one byte per level and memory use does not
+ *        depend on the size of the document.
+ */
+template <class Handler>
+void sax_parse(scanner &sc, Handler &h)
+{
+    json_reader::machine m;
+    while (true) {
+        switch (m.step(sc)) {
+        case json_reader::NULL_TK:
+            h.on_null();
+            break;
+        case json_reader::BOOL_TK:
+            h.on_bool(m.scalar().uint_value != 0);
+            break;
+        case json_reader::SIGNED_TK:
+            h.on_int(m.scalar().int_value);
+            break;
+        case json_reader::UNSIGNED_TK:
+            h.on_uint(m.scalar().uint_value);
+            break;
+        case json_reader::REAL_TK:
+            h.on_real(m.scalar().real_value);
+            break;
+        case json_reader::STRING_TK:
+            h.on_string(std::string_view(sc.token));
+            break;
+        case json_reader::KEY_TK:
+            h.on_key(std::string_view(sc.token));
+            break;
+        case json_reader::START_OBJECT_TK:
+            h.start_object();
+            break;
+        case json_reader::END_OBJECT_TK:
+            h.end_object();
+            break;
+        case json_reader::START_ARRAY_TK:
+            h.start_array();
+            break;
+        case json_reader::END_ARRAY_TK:
+            h.end_array();
+            break;
+        default:
+            return;
+        } // end switch //
+    } // end while //
+}
+
+/**
+ * @brief Parse a document with sax_parse(), adding the position to errors
+ *        like json::parse().
+ */
+template <class Handler>
+void sax_parse_document(scanner &sc, Handler &h)
+{
+    try {
+        sax_parse(sc, h);
+    }
+    catch (const std::exception &ex) {
+        throw std::runtime_error(std::string("Syntax error ") + ex.what()
+                                 + " in line " + std::to_string(sc.cur_line)
+                                 + ", column " + std::to_string(sc.cur_col));
+    }
+}
+
+template <class Handler>
+void sax_parse(const char *data, size_t size, Handler &h)
+{
+    scanner sc(data, size);
+    sax_parse_document(sc, h);
+}
+
+template <class Handler>
+void sax_parse(std::string_view s, Handler &h)
+{
+    sax_parse(s.data(), s.size(), h);
+}
+
+template <class Handler>
+void sax_parse(std::istream &is, Handler &h)
+{
+    scanner sc(is);
+    sax_parse_document(sc, h);
+}
+
+} // end namespace jsonx //
+
+#endif // SAX_HPP
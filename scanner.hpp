@@ -2,17 +2,46 @@
 #define SCANNER_HPP
 
 #include <iostream>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <cctype>
+#include <cstring>
 
 namespace jsonx {
 
+/**
+ * @brief Characters that end a scalar token.
+ */
+inline bool is_delimiter(int ch)
+{
+    return std::isspace(ch) || (ch == ',') || (ch == ']') || (ch == '}');
+}
+
+/**
+ * @brief Character scanner over a contiguous range of bytes.
+ *        The range is either supplied by the caller or is an internal
+ *        block that is refilled from an input stream.
+ *        cur_ch always is the byte at data(), next_ch the byte after it.
+ */
 class scanner
 {
 public:
-    scanner(std::istream &_is): is{_is}
+    static const size_t BLOCK_SIZE{64 * 1024};
+
+    scanner(const char *data, size_t size): pos{data}, end{data + size}
     {
-        get_ch();
-        get_ch();
+        start();
+    }
+
+    scanner(std::string_view s): scanner(s.data(), s.size()) {}
+
+    scanner(std::istream &_is): is{&_is}, block(BLOCK_SIZE)
+    {
+        pos = end = block.data();
+        refill();
+        start();
     }
 
     bool eof() const { return cur_ch == EOF; }
@@ -21,8 +50,10 @@ public:
     {
         if (eof())
             return;
-        cur_ch = next_ch;
-        next_ch = is.get();
+        ++pos;
+        if (is && (end - pos < 2))
+            refill();
+        load();
         if (eof())
             return;
         if (cur_ch == '\n') {
@@ -49,16 +80,96 @@ public:
         } // end while //
     }
 
+    /**
+     * @brief Contiguous bytes starting at cur_ch.
+     */
+    const char *data() const { return pos; }
+    size_t avail() const { return end - pos; }
+
+    /**
+     * @brief Advance by n bytes (1 <= n <= avail()) that are known not
+     *        to contain a line break.
+     */
+    void skip(size_t n)
+    {
+        pos += n - 1;
+        cur_col += static_cast<int>(n - 1);
+        get_ch();
+    }
+
     int cur_ch{0x00};
     int cur_line{1};
-    int cur_col{0};
+    int cur_col{1};
     int next_ch{0x00};
 
+    // Scratch buffer for the token being recognized:
+    std::string token;
+
+    // Arena for the parsed nodes, heap if nullptr:
+    std::pmr::memory_resource *arena{nullptr};
+
 private:
-    std::istream &is;
+    void start()
+    {
+        load();
+        if (eof())
+            return;
+        if (cur_ch == '\n') {
+            cur_line += 1;
+            cur_col = 0;
+        } else {
+            cur_col += 1;
+        }
+    }
+
+    void load()
+    {
+        cur_ch  = (pos < end)     ? static_cast<unsigned char>(pos[0]) : EOF;
+        next_ch = (pos + 1 < end) ? static_cast<unsigned char>(pos[1]) : EOF;
+    }
+
+    void refill()
+    {
+        char *buf = block.data();
+        size_t n = end - pos;
+        std::memmove(buf, pos, n);
+        // Take whatever the stream has buffered, but block for at most
+        // one character, so interactive streams are not read ahead.
+        std::streamsize got = is->readsome(buf + n, block.size() - n);
+        if (got <= 0) {
+            int c = is->get();
+            if (c == EOF) {
+                is = nullptr;
+            } else {
+                buf[n++] = static_cast<char>(c);
+                got = is->readsome(buf + n, block.size() - n);
+            }
+        }
+        if (got > 0)
+            n += got;
+        pos = buf;
+        end = buf + n;
+    }
+
+    const char       *pos{nullptr};
+    const char       *end{nullptr};
+    std::istream     *is{nullptr};
+    std::vector<char> block;
     bool in_comment{false};
 };
 
+/**
+ * @brief Read a string literal at the current position into s,
+ *        resolving escape sequences.
+ */
+void parse_string(scanner &sc, std::string &s);
+
+/**
+ * @brief Read the scalar token (null, true, false or a number) at the
+ *        current position into sc.token, empty if there is none.
+ */
+const std::string &parse_token(scanner &sc);
+
 } // end namespace jsonx //
 
 #endif // SCANNER_HPP
@@ -0,0 +1,84 @@
+#include "simd.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSONX_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace jsonx {
+
+static inline bool is_string_special(unsigned char ch)
+{
+    return (ch == '"') || (ch == '\\') || (ch < 0x20);
+}
+
+static const char *find_string_special_scalar(const char *p, const char *last)
+{
+    while ((p < last) && !is_string_special(static_cast<unsigned char>(*p)))
+        ++p;
+    return p;
+}
+
+#ifdef JSONX_X86_SIMD
+
+__attribute__((target("sse2")))
+static const char *find_string_special_sse2(const char *p, const char *last)
+{
+    const __m128i quote  = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    const __m128i ctrl   = _mm_set1_epi8(0x1f);
+    while (last - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, escape)),
+                    _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    } // end while //
+    return find_string_special_scalar(p, last);
+}
+
+__attribute__((target("avx2")))
+static const char *find_string_special_avx2(const char *p, const char *last)
+{
+    const __m256i quote  = _mm256_set1_epi8('"');
+    const __m256i escape = _mm256_set1_epi8('\\');
+    const __m256i ctrl   = _mm256_set1_epi8(0x1f);
+    while (last - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i m = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, escape)),
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    } // end while //
+    return find_string_special_sse2(p, last);
+}
+
+#endif // JSONX_X86_SIMD
+
+typedef const char *(*find_fn_t)(const char *, const char *);
+
+static find_fn_t select_find_string_special()
+{
+#ifdef JSONX_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return find_string_special_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return find_string_special_sse2;
+#endif
+    return find_string_special_scalar;
+}
+
+const char *find_string_special(const char *first, const char *last)
+{
+    static const find_fn_t fn = select_find_string_special();
+    return fn(first, last);
+}
+
+} // end namespace jsonx //
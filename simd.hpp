@@ -0,0 +1,15 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+namespace jsonx {
+
+/**
+ * @brief Find the first '"', '\\' or control character (< 0x20)
+ *        in [first, last). Uses AVX2 or SSE2 when the CPU supports it.
+ * @return Pointer to the character found or last.
+ */
+const char *find_string_special(const char *first, const char *last);
+
+} // end namespace jsonx //
+
+#endif // SIMD_HPP
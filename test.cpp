@@ -1,9 +1,25 @@
 
 #include "jsonx.hpp"
-
+#include "sax.hpp"
+#include "json_reader.hpp"
+#include "json_push_parser.hpp"
+#include "json_lazy.hpp"
+#include "ndjson.hpp"
+#include "cbor.hpp"
+#include "msgpack.hpp"
+#include "json_tape.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+#include <thread>
 
 #undef NDEBUG
 #include <assert.h>
@@ -11,6 +27,8 @@
 using namespace std;
 using namespace jsonx;
 
+static const size_t scanner_block{64 * 1024};
+
 static bool string_arg_val(string s)
 {
     return (s == "Test");
@@ -39,6 +57,57 @@ static bool string_arg_const_ptr(const char *s)
     return (string(s) == "Test");
 }
 
+// Bytes of a hex dump, as in the examples of the RFCs:
+static string from_hex(const char *hex)
+{
+    string s;
+    for (; hex[0] && hex[1]; hex += 2)
+        s.push_back(static_cast<char>(stoi(string(hex, 2), nullptr, 16)));
+    return s;
+}
+
+// Builds a tree from sax_parse() events:
+struct tree_builder: sax_handler {
+    json root;
+    vector<json*> stack;
+    string key;
+
+    json &slot() {
+        if (stack.empty())
+            return root;
+        json &top = *stack.back();
+        return top.isArray() ? top.emplaceBack() : top.emplace(key);
+    }
+    void on_null() { slot().setNull(); }
+    void on_bool(bool v) { slot() = v; }
+    void on_int(int64_t v) { slot() = v; }
+    void on_uint(uint64_t v) { slot() = v; }
+    void on_real(json_real_t v) { slot() = v; }
+    void on_string(string_view v) { slot() = string(v); }
+    void on_key(string_view k) { key = k; }
+    void start_object() { start(json::OBJECT_T); }
+    void end_object() { stack.pop_back(); }
+    void start_array() { start(json::ARRAY_T); }
+    void end_array() { stack.pop_back(); }
+
+    void start(json::DataType t) {
+        json &s = slot();
+        s = json(t);
+        stack.push_back(&s);
+    }
+};
+
+// Only counts unsigned numbers and the nesting depth:
+struct depth_counter: sax_handler {
+    size_t numbers{0};
+    size_t depth{0};
+    size_t max_depth{0};
+
+    void on_uint(uint64_t) { ++numbers; }
+    void start_array() { max_depth = std::max(max_depth, ++depth); }
+    void end_array() { --depth; }
+};
+
 int main(int, const char *[])
 {
     cout << "JsonX Test START" << endl;
@@ -88,6 +157,20 @@ int main(int, const char *[])
             });
             //cout << "<" << x9.write() << ">" << endl;
             assert(x9.write() == "[false,1,{\"First\":99,\"Second\":\"Blub\",\"Third\":true},\"Bla\"]");
+
+            // Containers with the default allocator:
+            std::vector<json> v{json(1), json("two")};
+            json x10(v);
+            assert(x10.write() == "[1,\"two\"]");
+            std::map<std::string, json> m{{"b", json(2)}, {"a", json(1)}};
+            json x11(m);
+            assert(x11.write() == "{\"a\":1,\"b\":2}");
+            std::string keys;
+            for (const json_object_value_t &item : x11.toObject()) {
+                std::string key = item.first;
+                keys += key;
+            }
+            assert(keys == "ab");
         }
         cout << "OK" << endl;
         cout << endl;
@@ -330,6 +413,357 @@ int main(int, const char *[])
         cout << "OK" << endl;
         cout << endl;
 
+        cout << "Testing numbers:" << endl;
+        {
+            json x;
+
+            x.parse("007");
+            assert(x.isUnsigned());
+            assert(x.toUnsigned() == 7);
+
+            x.parse("18446744073709551615");
+            assert(x.isUnsigned());
+            assert(x.toUnsigned() == 18446744073709551615ULL);
+
+            x.parse("-9223372036854775808");
+            assert(x.isSigned());
+            assert(x.toSigned() == INT64_MIN);
+
+            x.parse("-0");
+            assert(x.isSigned());
+            assert(x.toSigned() == 0);
+
+            x.parse("18446744073709551616");
+            assert(x.isReal());
+            assert(x.toReal() == 18446744073709551616.0);
+
+            x.parse("[0.5,-1.25e-3,1E2]");
+            assert(x[0].isReal() && (x[0].toReal() == 0.5));
+            assert(x[1].isReal() && (x[1].toReal() == -1.25e-3));
+            assert(x[2].isReal() && (x[2].toReal() == 100.0));
+
+            for (const char *s : {"+1.5", "01.5", "1.", ".5", "1e", "-", "1x", "1e999"}) {
+                bool failed{false};
+                try {
+                    x.parse(s);
+                }
+                catch (const exception &) {
+                    failed = true;
+                }
+                assert(failed);
+            }
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing real formatting:" << endl;
+        {
+#ifdef JSONX_LEGACY_REAL_FORMAT
+            assert(json(0.1 + 0.2).write() == "0.3");
+            assert(json(100.0).write() == "100");
+            assert(json(0.5).toString() == "0.500000");
+#else
+            assert(json(0.1 + 0.2).write() == "0.30000000000000004");
+            assert(json(100.0).write() == "100.0");
+            assert(json(-0.0).write() == "-0.0");
+            assert(json(1e300).write() == "1e+300");
+            assert(json(11.31).toString() == "11.31");
+            assert(json(3.0).toString() == "3.0");
+
+            vector<double> values{0.0, -0.0, 1.0, -1.5, 0.1, 1.0 / 3.0, 123456789012345678.0,
+                                  numeric_limits<double>::min(),
+                                  numeric_limits<double>::max(),
+                                  numeric_limits<double>::lowest(),
+                                  numeric_limits<double>::denorm_min(),
+                                  numeric_limits<double>::epsilon()};
+            mt19937_64 rng(4711);
+            while (values.size() < 100000) {
+                // Any finite bit pattern:
+                const uint64_t bits = rng();
+                double d;
+                memcpy(&d, &bits, sizeof(d));
+                if (isfinite(d))
+                    values.push_back(d);
+            }
+            json a(json::ARRAY_T);
+            for (double d : values)
+                a.add(d);
+            json b;
+            b.parse(a.write());
+            assert(b.size() == values.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                const json &r = b[static_cast<json_index_t>(i)];
+                const double v = r.toReal();
+                assert(r.isReal());
+                assert(memcmp(&v, &values[i], sizeof(double)) == 0);
+                json s;
+                s.parse(json(values[i]).toString());
+                assert(s.toReal() == values[i]);
+            }
+#endif
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing strings:" << endl;
+        {
+            json x;
+
+            x.parse("\"\"");
+            assert(x.isString());
+            assert(x.toString().empty());
+
+            x.parse("\"Gr\xc3\xbc\xc3\x9f Gott, 0123456789 abcdefghijklmnopqrstuvwxyz\"");
+            assert(x == "Gr\xc3\xbc\xc3\x9f Gott, 0123456789 abcdefghijklmnopqrstuvwxyz");
+
+            x.parse("\"0123456789abcdefghijklmnopqrstuvwxyz\\t0123456789abcdefghijklmnopqrstuvwxyz\\\\\\\"\"");
+            assert(x == "0123456789abcdefghijklmnopqrstuvwxyz\t0123456789abcdefghijklmnopqrstuvwxyz\\\"");
+
+            x.parse("\"A\\0B\"");
+            assert(x.toStringRef() == string("A\0B", 3));
+
+            x.parse("\"Line 1\nLine 2\"");
+            assert(x == "Line 1\nLine 2");
+
+            string s(3 * scanner_block, 'x');
+            s[scanner_block - 1] = '\\';
+            s[scanner_block] = 'n';
+            istringstream is("\"" + s + "\"");
+            x.parse(is);
+            s.replace(scanner_block - 1, 2, "\n");
+            assert(x.toStringRef() == s);
+
+            bool failed{false};
+            try {
+                x.parse("\"Unterminated");
+            }
+            catch (const exception &ex) {
+                failed = true;
+                assert(string(ex.what()) == "Syntax error Premature EOF in line 1, column 14");
+            }
+            assert(failed);
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing short strings:" << endl;
+        {
+            for (size_t n = 0; n < 20; ++n) {
+                const string s(n, 'a' + n);
+                json x(s);
+                assert(x.isString());
+                assert(x.toStringView() == s);
+                assert(x.c_str() == s);
+                json y(x);
+                json z(std::move(y));
+                assert(z == x);
+                assert(!y.isDefined());
+                json_array_t v;
+                for (int i = 0; i < 10; ++i)
+                    v.push_back(x);
+                for (const json &j : v)
+                    assert(j.toString() == s);
+                z.toStringRef() += "!";
+                assert(z.toString() == s + "!");
+                x.parse("[\"" + s + "\"]");
+                assert(x[0].toStringView() == s);
+            }
+            json x(string("A\0B", 3));
+            assert(x.toStringView() == string_view("A\0B", 3));
+            x = "Short";
+            assert(x == "Short");
+            x = "Not a short string any more";
+            assert(x == "Not a short string any more");
+            x = "Short";
+            assert(x == "Short");
+
+            // Reading leaves short strings in the node:
+            json cc;
+            cc.parse("[\"one\", \"two\", \"three\", \"four\", \"five\","
+                     " \"six\", \"seven\", \"eight\", \"nine\"]");
+            auto in_node = [](const json &v) {
+                const char *p = v.c_str();
+                return (p >= reinterpret_cast<const char*>(&v))
+                    && (p < reinterpret_cast<const char*>(&v + 1));
+            };
+            const json &c = cc;
+            const string &s0 = c[0];
+            const string &s1 = cc[1];
+            string s2 = cc[2];
+            for (json_index_t i = 0; i < 9; ++i) {
+                assert(c[i].toStringRef() == cc[i].toStringView());
+                assert(in_node(c[i]));
+            }
+            assert((s0 == "one") && (s1 == "two") && (s2 == "three"));
+            json c0(c[0]);
+            assert(c0 == "one");
+            string &m3 = cc[3];
+            m3 += "!";
+            assert(cc[3] == "four!");
+            assert(!in_node(c[3]));
+
+            // Const reads from many threads, which must not write:
+            vector<thread> readers;
+            for (int t = 0; t < 4; ++t) {
+                readers.emplace_back([&c]() {
+                    for (int i = 0; i < 1000; ++i) {
+                        const string &s = c[i % 9];
+                        assert(!s.empty() && (c[i % 9].toStringRef() == s));
+                    }
+                });
+            }
+            for (auto &t : readers)
+                t.join();
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing moves:" << endl;
+        {
+            json a;
+            a.parse("[1, [2, 3], {\"x\": \"A string too long to be short\"}]");
+            const json_array_t *payload = &a.toArrayRef();
+            json x;
+            x.add(std::move(a));
+            assert(!a.isDefined());
+            assert(&x[0].toArrayRef() == payload);
+            json y;
+            y = std::move(x);
+            assert(!x.isDefined());
+            assert(&y[0].toArrayRef() == payload);
+            y = std::move(y[0]);
+            assert(&y.toArrayRef() == payload);
+            assert(y.write() == "[1,[2,3],{\"x\":\"A string too long to be short\"}]");
+
+            json o;
+            const char *chars = y[2]["x"].c_str();
+            o.add(string("k"), std::move(y[2]["x"]));
+            assert(o["k"].c_str() == chars);
+            o.add("k", 5);
+            assert(o["k"] == 5);
+            o.emplace("e", "Emplaced").toStringRef() += "!";
+            assert(o["e"] == "Emplaced!");
+            json &z = o.emplace("z", json::ARRAY_T);
+            z.emplaceBack(1);
+            z.emplaceBack().add("Filled in later");
+            z.emplaceBack(json::NULL_T);
+            assert(z.write() == "[1,[\"Filled in later\"],null]");
+
+            json b = jarray(1, "two", jobject(jitem("four", jarray()), jitem("three", 3)));
+            assert(b.write() == "[1,\"two\",{\"four\":[],\"three\":3}]");
+            // A lookup taken before b is copied would move out of the copy
+            // too, so the item is moved out of b after copying it:
+            json c = jarray(b);
+            c.add(std::move(b[2]));
+            assert(c.write() == "[[1,\"two\",{\"four\":[],\"three\":3}],{\"four\":[],\"three\":3}]");
+            assert(!b[2].isDefined());
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing copy on write:" << endl;
+        {
+            json a;
+            a.parse("{\"list\": [1, 2, {\"deep\": \"A string too long to be short\"}], \"n\": 1}");
+            const json &ca = a;
+            json b(a);
+            const json &cb = b;
+            assert(&ca.toObjectRef() == &cb.toObjectRef());
+            assert(&ca["list"].toArrayRef() == &cb["list"].toArrayRef());
+
+            b["n"] = 2;
+            assert(&ca.toObjectRef() != &cb.toObjectRef());
+            assert(&ca["list"].toArrayRef() == &cb["list"].toArrayRef());
+            assert(a["n"] == 1);
+            assert(b["n"] == 2);
+
+            b["list"][0] = 10;
+            b["list"].add("new");
+            assert(a.write() == "{\"list\":[1,2,{\"deep\":\"A string too long to be short\"}],\"n\":1}");
+            assert(b["list"].write() == "[10,2,{\"deep\":\"A string too long to be short\"},\"new\"]");
+            assert(ca["list"][2]["deep"].c_str() == cb["list"][2]["deep"].c_str());
+
+            b["list"][2]["deep"].toStringRef() += "!";
+            assert(a["list"][2]["deep"] == "A string too long to be short");
+            assert(b["list"][2]["deep"] == "A string too long to be short!");
+
+            json s("Another string too long to be short");
+            json t = s;
+            t = "Changed";
+            assert(s == "Another string too long to be short");
+            t = s;
+            s.toStringRef()[0] = 'a';
+            assert(t == "Another string too long to be short");
+            assert(s == "another string too long to be short");
+
+            // References to a payload taken before a copy modify the original only:
+            {
+                json a;
+                a.parse("{\"x\": 1, \"list\": [1, [2]], \"s\": \"A string too long to be short\"}");
+                // Expected values in insertion order, written in container order:
+                auto same = [](const json &v, const char *text) {
+                    json expected;
+                    expected.parse(text);
+                    return v.write() == expected.write();
+                };
+                json_array_t &list = a["list"].toArrayRef();
+                json_object_t &members = a.toObjectRef();
+                string &str = a["s"].toStringRef();
+                json c = a;
+                json d = a["list"];
+                list.push_back(json(3));
+                members.find("x")->second = 7;
+                str += "!";
+                assert(same(a, "{\"x\":7,\"list\":[1,[2],3],\"s\":\"A string too long to be short!\"}"));
+                assert(same(c, "{\"x\":1,\"list\":[1,[2]],\"s\":\"A string too long to be short\"}"));
+                assert(d.write() == "[1,[2]]");
+
+                // Assigning a new payload makes copies share again:
+                a["list"] = jarray(4, 5);
+                const json &ca = a;
+                const json e = a["list"];
+                assert(&ca["list"].toArray() == &e.toArray());
+
+                // Lookups do not stop copies from sharing:
+                json f;
+                f.parse("{\"list\": [1, 2], \"n\": 1}");
+                f["n"] = f["list"][0].toInt() + 1;
+                f.emplace("e", 3);
+                f["list"].emplaceBack(3);
+                json g = f;
+                const json &cf = f, &cg = g;
+                assert(&cf.toObject() == &cg.toObject());
+                assert(same(g, "{\"list\":[1,2,3],\"n\":2,\"e\":3}"));
+            }
+
+            // Values built by a document are copied out of its arena:
+            json_document d;
+            d.parse("[[1, 2], \"A string too long to be short\"]");
+            json e(d.root());
+            d.reset();
+            assert(e.write() == "[[1,2],\"A string too long to be short\"]");
+
+            // Copies are released from many threads:
+            json big;
+            for (int i = 0; i < 1000; ++i)
+                big.add(jarray(i, "A string too long to be short"));
+            vector<thread> threads;
+            for (int t = 0; t < 8; ++t) {
+                threads.emplace_back([&big, t]() {
+                    for (int i = 0; i < 1000; ++i) {
+                        json copy(big);
+                        if (i % 100 == 0)
+                            copy[i][0] = t;
+                    }
+                });
+            }
+            for (auto &t : threads)
+                t.join();
+            assert(big[999][0] == 999);
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
         cout << "Testing array subscription:" << endl;
         {
             json x;
@@ -420,7 +854,11 @@ int main(int, const char *[])
             double d1 = x["Prozent"];
             assert(d1 == 99.9);
             string s3 = x.write();
+#if defined(JSONX_ORDERED_OBJECTS)
+            assert(s3 == "{\"Mama\":\"Maria\",\"Papa\":\"Josef\",\"Jahr\":2020,\"Schaltjahr\":false,\"Prozent\":99.9}");
+#else
             assert(s3 == "{\"Jahr\":2020,\"Mama\":\"Maria\",\"Papa\":\"Josef\",\"Prozent\":99.9,\"Schaltjahr\":false}");
+#endif
         }
         cout << "OK" << endl;
         cout << endl;
@@ -485,6 +923,1159 @@ int main(int, const char *[])
         cout << "OK" << endl;
         cout << endl;
 
+        cout << "Testing buffer input:" << endl;
+        {
+            string s{"[\"Element\""};
+            for (int i = 0; i < 20000; ++i)
+                s += ", // Comment\n" + to_string(i) + ", \"Text " + to_string(i) + "\"";
+            s += "]";
+
+            json x1, x2, x3;
+            x1.parse(string_view(s));
+            x2.parse(s.data(), s.size());
+            istringstream is(s);
+            x3.parse(is);
+            assert(x1.size() == 40001);
+            assert(x1[40000] == "Text 19999");
+            assert(x1 == x2);
+            assert(x1 == x3);
+
+            string e1, e2;
+            try {
+                x1.parse("[1,\n  2,\n  x]");
+            }
+            catch (const exception &ex) {
+                e1 = ex.what();
+            }
+            try {
+                istringstream ies("[1,\n  2,\n  x]");
+                x2.parse(ies);
+            }
+            catch (const exception &ex) {
+                e2 = ex.what();
+            }
+            assert(e1 == "Syntax error Unexpected token: \"x\" in line 3, column 4");
+            assert(e1 == e2);
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing buffer output:" << endl;
+        {
+            json x;
+            x.parse("{\"a\": [1, -2, 3.5, 1e+20, true, false, null], \"b\": \"Tab\\t \\\"quoted\\\" \\\\\"}");
+            const string expected{"{\"a\":[1,-2,3.5,1e+20,true,false,null],\"b\":\"Tab\\t \\\"quoted\\\" \\\\\"}"};
+            ostringstream os;
+            os << x;
+            assert(os.str() == expected);
+            assert(x.write() == expected);
+
+            string s{"HTTP body: "};
+            x.write_to(s);
+            assert(s == "HTTP body: " + expected);
+
+            char buffer[128];
+            const size_t n = x.write_to(buffer, sizeof(buffer));
+            assert(string(buffer, n) == expected);
+            assert(x.write_to(buffer, expected.size()) == expected.size());
+            bool failed{false};
+            try {
+                x.write_to(buffer, expected.size() - 1);
+            }
+            catch (const exception &) {
+                failed = true;
+            }
+            assert(failed);
+            json numbers = jarray(1, -2, 0.5);
+            assert(numbers.write_to(buffer, 10) == 10);
+            assert(string(buffer, 10) == "[1,-2,0.5]");
+
+            // Larger than the blocks and the initial string buffer:
+            json big;
+            for (int i = 0; i < 5000; ++i)
+                big.add(jarray(i, string(i % 50, 'x') + "\n"));
+            big.add(string(100000, 'y'));
+            string b1, b2 = big.write();
+            ostringstream bos;
+            big.write(bos);
+            big.write_to(b1);
+            assert(b1 == bos.str());
+            assert(b1 == b2);
+            json parsed;
+            parsed.parse(b1);
+            assert(parsed.write() == b1);
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing parallel output:" << endl;
+        {
+            json small;
+            small.parse("{\"a\": [1, -2.5, \"x\"], \"b\": {}, \"c\": []}");
+            // Split into chunks, with undefined items and members:
+            json big_array;
+            for (int i = 0; i < 10000; ++i) {
+                if (i % 3 == 0)
+                    big_array.addUndefined();
+                else
+                    big_array.add(jarray(i, "s" + to_string(i)));
+            }
+            // The undefined members come first in all containers:
+            json big_object, undefined_object;
+            for (int i = 0; i < 10000; ++i) {
+                const string key = ((i < 5000) ? "a" : "b") + to_string(100000 + i);
+                if ((i < 5000) || (i % 5 == 0))
+                    big_object.addUndefined(key);
+                else
+                    big_object.add(key, i);
+                undefined_object.addUndefined(key);
+            }
+            json outer;
+            outer.add("array", big_array);
+            outer.add("object", big_object);
+            outer.add("nested", jarray(big_array, small, undefined_object, big_object));
+
+            for (const json &d : {json(), small, big_array, big_object, undefined_object, outer}) {
+                const string expected = d.write();
+                string s{"HTTP body: "};
+                d.write_parallel(s);
+                assert(s == "HTTP body: " + expected);
+                ostringstream os;
+                d.write_parallel(os);
+                assert(os.str() == expected);
+            }
+            assert(undefined_object.write() == "{}");
+
+            // From tasks that occupy every worker of the shared pool:
+            thread_pool &pool = thread_pool::shared();
+            vector<string> results(pool.size());
+            vector<future<void>> done;
+            for (string &r : results)
+                done.push_back(pool.submit([&]() {
+                    outer.write_parallel(r);
+                    ostringstream os;
+                    outer.write_parallel(os);
+                    assert(os.str() == r);
+                }));
+            for (future<void> &f : done)
+                f.get();
+            for (const string &r : results)
+                assert(r == outer.write());
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing index parse engine:" << endl;
+        {
+            vector<string> docs{
+                "",
+                "null",
+                " -17 ",
+                "[false,1,{\"First\":99,\"Second\":\"Blub\",\"Third\":true},\"Bla\"]",
+                "[\"A\" // Element A\n \n//##Kommentarzeile \n , \"B\"]//Schlu\xc3\x9f",
+                "{\"url\": \"http://df9ry.de\", // \"Comment\" with quotes\n \"b\": [1, 2, 3,],}",
+                "[,1,,2,]",
+                "{\"a\":,\"b\":1}",
+                "{\"a\":1,\"a\":2}",
+                "[1 2 \"x\"\"y\"]"
+            };
+            // Escapes, quotes and comments across the 64 byte block boundaries:
+            for (size_t i = 55; i < 70; ++i) {
+                docs.push_back("[\"" + string(i, 'x') + "\\\\\\\"\", \"" + string(i, 'y') + "\\\\\"]");
+                docs.push_back("[" + string(i, ' ') + "// \"Comment\" [\n\"A\", 1]");
+            }
+            string big{"{"};
+            for (int i = 0; i < 1000; ++i)
+                big += "\"Key" + to_string(i) + "\": [" + to_string(i) + ", -1.5e3, \"V\\\"al\\\\ue\", null], // Comment\n";
+            docs.push_back(big + "}");
+
+            for (const string &d : docs) {
+                json x1, x2;
+                x1.parse(d);
+                x2.parse(d, json::INDEX_E);
+                assert(x1.isDefined() == x2.isDefined());
+                assert(x1.write() == x2.write());
+            }
+
+            for (const char *d : {"[1,\n  2,\n  x]", "{\"a\" 1}", "[1,2", "[\"abc", "[}]", "\"\\q\""}) {
+                string e1, e2;
+                json x;
+                try {
+                    x.parse(d);
+                }
+                catch (const exception &ex) {
+                    e1 = ex.what();
+                }
+                try {
+                    x.parse(d, json::INDEX_E);
+                }
+                catch (const exception &ex) {
+                    e2 = ex.what();
+                }
+                assert(!e1.empty());
+                assert(e1 == e2);
+                assert(!x.isDefined());
+            }
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing parallel parse engine:" << endl;
+        {
+            vector<string> docs{
+                "",
+                " 42 ",
+                "{\"a\": [1, 2]}",
+                "[]",
+                " // Comment\n [1, 2, 3] trailing",
+                "[,1,,2,]",
+                "[1 2 \"x\"\"y\"]"
+            };
+            // Large enough to be split, with commas, brackets and escapes
+            // inside strings and comments:
+            string big{"["};
+            for (int i = 0; i < 5000; ++i) {
+                big += "{\"id\": " + to_string(i) + ", \"s\": \"a, ]} \\\" [\\\\\", \"l\": [1, -2.5, null, [true]]}, // ,] \"\n";
+                big += (i % 7) ? "\"x\", " : ", ";
+            }
+            docs.push_back(big + "]");
+
+            for (const string &d : docs) {
+                json x1, x2;
+                x1.parse(d);
+                x2.parse(d, json::PARALLEL_E);
+                assert(x1.isDefined() == x2.isDefined());
+                assert(x1.write() == x2.write());
+            }
+            json x;
+            x.parse(docs.back(), json::PARALLEL_E);
+            assert(x.size() == 5000 + 5000 - 715);
+            assert(x[0]["s"] == "a, ]} \" [\\");
+
+            for (string d : {string("[1,\n  2,\n  x]"), string("[1,2"), string("[}]"),
+                             string("[\"abc"), big + "x]", big + "{]", big}) {
+                string e1, e2;
+                try {
+                    x.parse(d);
+                }
+                catch (const exception &ex) {
+                    e1 = ex.what();
+                }
+                try {
+                    x.parse(d, json::PARALLEL_E);
+                }
+                catch (const exception &ex) {
+                    e2 = ex.what();
+                }
+                assert(!e1.empty());
+                assert(e1 == e2);
+                assert(!x.isDefined());
+            }
+
+            // From tasks that occupy every worker of the shared pool:
+            thread_pool &pool = thread_pool::shared();
+            assert(!pool.is_worker());
+            vector<json> results(pool.size());
+            vector<future<void>> done;
+            for (json &r : results)
+                done.push_back(pool.submit([&]() {
+                    assert(thread_pool::shared().is_worker());
+                    r.parse(docs.back(), json::PARALLEL_E);
+                }));
+            for (future<void> &f : done)
+                f.get();
+            for (const json &r : results)
+                assert(r.size() == 5000 + 5000 - 715);
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing flat_map:" << endl;
+        {
+            flat_map<string, int> m;
+            assert(m.empty());
+            for (int i : {5, 3, 9, 1, 7, 3})
+                m.emplace(to_string(i), i);
+            assert(m.size() == 5);
+            assert(!m.emplace(string("9"), 0).second);
+            string keys;
+            for (const auto &p : m)
+                keys += p.first;
+            assert(keys == "13579");
+            assert(m.find("7")->second == 7);
+            assert(m.find("4") == m.end());
+            m["4"] = 4;
+            assert(m.find("4")->second == 4);
+            assert(m.erase("5") == 1);
+            assert(m.erase("5") == 0);
+            m.erase(m.find("1"));
+            keys.clear();
+            for (const auto &p : m)
+                keys += p.first;
+            assert(keys == "3479");
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing ordered_map:" << endl;
+        {
+            ordered_map<string, int> m;
+            assert(m.empty());
+            for (int i : {5, 3, 9, 1, 7, 3})
+                m.emplace(to_string(i), i);
+            assert(m.size() == 5);
+            assert(!m.emplace(string("9"), 0).second);
+            string keys;
+            for (const auto &p : m)
+                keys += p.first;
+            assert(keys == "53917");
+            assert(m.find("7")->second == 7);
+            assert(m.find("4") == m.end());
+            m["4"] = 4;
+            assert(m.find("4")->second == 4);
+            assert(m.erase("5") == 1);
+            assert(m.erase("5") == 0);
+            m.erase(m.find("1"));
+            keys.clear();
+            for (const auto &p : m)
+                keys += p.first;
+            assert(keys == "3974");
+            for (int i = 0; i < 1000; ++i)
+                m.emplace("Key" + to_string(i), i);
+            for (int i = 0; i < 1000; i += 2)
+                m.erase("Key" + to_string(i));
+            assert(m.size() == 504);
+            for (int i = 0; i < 1000; ++i)
+                assert((m.find("Key" + to_string(i)) == m.end()) == (i % 2 == 0));
+            assert((++m.find("Key1"))->first == "Key3");
+        }
+#if defined(JSONX_ORDERED_OBJECTS)
+        {
+            const string d{"{\"z\":1,\"a\":{\"y\":[],\"b\":null},\"m\":\"x\"}"};
+            json x;
+            x.parse(d);
+            assert(x.write() == d);
+            x.parse(d, json::INDEX_E);
+            assert(x.write() == d);
+        }
+#endif
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing interned keys:" << endl;
+        {
+            json_key a("Name"), b(string("Name")), c(string_view("Other"));
+            assert(a == b);
+            assert(a.data() == b.data());
+            assert(a != c);
+            assert(a == "Name");
+            assert(a == string("Name"));
+            assert(a < c);
+            assert(c > "Name");
+            assert(string_view(a) == "Name");
+            assert(json_key().empty());
+            const size_t n = json_key::pool_size();
+            json_key d("Name");
+            assert(json_key::pool_size() == n);
+
+            vector<thread> threads;
+            vector<const char*> seen(8);
+            for (size_t t = 0; t < seen.size(); ++t) {
+                threads.emplace_back([t, &seen]() {
+                    for (int i = 0; i < 1000; ++i)
+                        json_key("Thread key " + to_string(i));
+                    seen[t] = json_key("Thread key 500").data();
+                });
+            }
+            for (auto &t : threads)
+                t.join();
+            for (const char *p : seen)
+                assert(p == seen[0]);
+            assert(json_key::pool_size() == n + 1000);
+
+#if defined(JSONX_INTERNED_KEYS)
+            assert(sizeof(json_key_t) == sizeof(void*));
+            json x;
+            x.parse("[{\"id\": 1, \"name\": \"A\"}, {\"id\": 2, \"name\": \"B\"}]");
+            auto key = [](const json &j) {
+                return j.toObject().begin()->first.data();
+            };
+            assert(key(x[0]) == key(x[1]));
+            assert(x[0]["name"] == "A");
+            assert(x.write() == "[{\"id\":1,\"name\":\"A\"},{\"id\":2,\"name\":\"B\"}]");
+#endif
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing documents:" << endl;
+        {
+            const string d{"{\"name\": \"Tab\\tstop\", \"list\": [1, -2, 3.5, null, \"abc\",,],"
+                           " \"obj\": {\"a\": true, \"a\": false, \"b\": {}}}"};
+            json x;
+            x.parse(d);
+            json_document doc;
+            for (auto engine : {json::SCANNER_E, json::INDEX_E, json::PARALLEL_E}) {
+                doc.parse(d, engine);
+                assert(doc.root() == x);
+                assert(doc.root().write() == x.write());
+                assert(doc["name"].toStringView() == "Tab\tstop");
+                assert(string(doc["name"].c_str()) == "Tab\tstop");
+                assert(doc["name"].toStringRef() == "Tab\tstop");
+                const string &abc = doc["list"][4];
+                assert(abc == "abc");
+                assert(doc["list"][4].toStringRef().data() == doc["list"][4].c_str());
+                assert(doc["list"].size() == 5);
+                assert(doc["list"][4].toString() == "abc");
+                assert(doc["obj"]["a"].toBool() == false);
+                json copy(doc["obj"]);
+                const json &root = doc;
+                string s = root.write();
+                doc.reset();
+                assert(!doc.root().isDefined());
+                assert(copy.write() == "{\"a\":false,\"b\":{}}");
+                assert(s == x.write());
+            }
+            // Strings are read in place, from any number of threads:
+            doc.parse("[\"first\", \"a string longer than short ones\"]");
+            assert(doc[0].toStringRef() == "first");
+            assert(doc[1].toStringRef() == "a string longer than short ones");
+            assert(doc[1].toStringRef().data() == doc[1].c_str());
+            vector<thread> readers;
+            for (int t = 0; t < 4; ++t) {
+                readers.emplace_back([&doc]() {
+                    for (int i = 0; i < 1000; ++i) {
+                        const string &s = doc[i % 2];
+                        assert(doc[i % 2].toStringRef() == s);
+                    }
+                });
+            }
+            for (auto &t : readers)
+                t.join();
+            doc.parse("[\"second\", \"another string longer than short\"]");
+            assert(doc[0].toStringRef() == "second");
+            assert(doc[1].toStringRef() == "another string longer than short");
+            istringstream is(d);
+            doc.parse(is);
+            assert(doc.root() == x);
+            try {
+                doc.parse("[1, 2");
+                assert(false);
+            }
+            catch (const exception &) {
+                assert(!doc.root().isDefined());
+            }
+            doc.parse_file("./test.jsonc");
+            json y;
+            y.parse_file("./test.jsonc");
+            assert(doc.root() == y);
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing SAX parser:" << endl;
+        {
+            const string d{"{\"name\": \"Tab\\tstop\", \"list\": [1, -2, 3.5, null, \"abc\",,],"
+                           " \"obj\": {\"a\": true, \"a\": false, \"b\": {}, \"c\": }, // Comment\n"
+                           " \"empty\": [], \"big\": 18446744073709551615}"};
+            json x;
+            x.parse(d);
+            tree_builder b1;
+            sax_parse(d, b1);
+            assert(b1.stack.empty());
+            assert(b1.root.write() == x.write());
+
+            tree_builder b2;
+            istringstream is(d);
+            sax_parse(is, b2);
+            assert(b2.root.write() == x.write());
+
+            for (const char *s : {"", "null", "true", "-7", "\"text\"", "[]", "[[],{}]"}) {
+                json y;
+                y.parse(s);
+                tree_builder b;
+                sax_parse(s, b);
+                assert(b.root.write() == y.write());
+            }
+
+            ifstream ifs("./test.jsonc");
+            tree_builder b3;
+            sax_parse(ifs, b3);
+            json y;
+            y.parse_file("./test.jsonc");
+            assert(b3.root == y);
+
+            // Nesting far deeper than recursive parsing could handle:
+            const size_t levels{200000};
+            depth_counter c;
+            sax_parse(string(levels, '[') + "1" + string(levels, ']'), c);
+            assert(c.numbers == 1);
+            assert(c.depth == 0);
+            assert(c.max_depth == levels);
+
+            for (const char *s : {"[1,\n  2,\n  x]", "{\"a\" 1}", "[1, 2", "[1}"}) {
+                string e1, e2;
+                try {
+                    x.parse(s);
+                }
+                catch (const exception &ex) {
+                    e1 = ex.what();
+                }
+                try {
+                    depth_counter c;
+                    sax_parse(s, c);
+                }
+                catch (const exception &ex) {
+                    e2 = ex.what();
+                }
+                assert(!e1.empty());
+                assert(e1 == e2);
+            }
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing pull parser:" << endl;
+        {
+            const string d{"{\"id\": 17, \"skip\": {\"a\": [1, {\"b\": []}], \"c\": \"x\"},\n"
+                           " \"list\": [-1, 2.5, true, null, \"s\",,], \"none\": ,\n"
+                           " \"name\": \"Tab\\tstop\"}"};
+            json_reader r(d);
+            assert(r.token_type() == json_reader::NONE_TK);
+            assert(r.next() == json_reader::START_OBJECT_TK);
+            assert(r.depth() == 1);
+            assert(r.next() == json_reader::KEY_TK);
+            assert(r.get_string_view() == "id");
+            assert(r.next() == json_reader::UNSIGNED_TK);
+            assert(r.get_uint() == 17);
+            assert(r.get_real() == 17.0);
+            assert(r.next() == json_reader::KEY_TK);
+            assert(r.get_string_view() == "skip");
+            r.skip_value();
+            assert(r.token_type() == json_reader::END_OBJECT_TK);
+            assert(r.depth() == 1);
+            assert(r.next() == json_reader::KEY_TK);
+            assert(r.get_string_view() == "list");
+            assert(r.next() == json_reader::START_ARRAY_TK);
+            assert(r.next() == json_reader::SIGNED_TK);
+            assert(r.get_int() == -1);
+            assert(r.next() == json_reader::REAL_TK);
+            assert(r.get_real() == 2.5);
+            assert(r.next() == json_reader::BOOL_TK);
+            assert(r.get_bool());
+            assert(r.next() == json_reader::NULL_TK);
+            assert(r.next() == json_reader::STRING_TK);
+            assert(r.get_string_view() == "s");
+            assert(r.next() == json_reader::END_ARRAY_TK);
+            // "none" has no value and is not reported:
+            assert(r.next() == json_reader::KEY_TK);
+            assert(r.get_string_view() == "name");
+            assert(r.line() == 3);
+            assert(r.next() == json_reader::STRING_TK);
+            assert(r.get_string_view() == "Tab\tstop");
+            bool failed{false};
+            try {
+                r.get_uint();
+            }
+            catch (const exception &) {
+                failed = true;
+            }
+            assert(failed);
+            assert(r.next() == json_reader::END_OBJECT_TK);
+            assert(r.depth() == 0);
+            assert(r.next() == json_reader::END_TK);
+            assert(r.next() == json_reader::END_TK);
+
+            // Stop early, the rest is never looked at:
+            json_reader early("[{\"id\": 1}, this is not json");
+            assert(early.next() == json_reader::START_ARRAY_TK);
+            assert(early.next() == json_reader::START_OBJECT_TK);
+            early.skip_value();
+            assert(early.token_type() == json_reader::END_OBJECT_TK);
+
+            for (const char *s : {"", "7", "\"text\""}) {
+                json_reader r1(s);
+                r1.next();
+                r1.skip_value();
+                assert(r1.next() == json_reader::END_TK);
+            }
+
+            istringstream is("[1,\n  2,\n  x]");
+            json_reader r2(is);
+            string e;
+            try {
+                while (r2.next() != json_reader::END_TK)
+                    ;
+            }
+            catch (const exception &ex) {
+                e = ex.what();
+            }
+            assert(e == "Syntax error Unexpected token: \"x\" in line 3, column 4");
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing push parser:" << endl;
+        {
+            // Parse d in pieces of n bytes, like json::parse():
+            auto push = [](const string &d, size_t n) {
+                json_push_parser p;
+                // The rest behind the value is left, as json::parse() does:
+                for (size_t i = 0; (i < d.size()) && !p.complete(); i += n) {
+                    const size_t size = min(n, d.size() - i);
+                    assert((p.feed(d.data() + i, size) == size) || p.complete());
+                }
+                p.finish();
+                assert(p.complete());
+                return p.take();
+            };
+            const vector<string> docs{
+                "",
+                " 42 ",
+                "-1.5e3",
+                "\"Tab\\tstop \\\"quoted\\\" \\\\\"",
+                "[false,1,{\"First\":99,\"Second\":\"Blub\",\"Third\":true},\"Bla\"]",
+                "[\"A\" // Element A\n \n//##Kommentarzeile \n , \"B\"]//Schlu\xc3\x9f",
+                "{\"url\": \"http://df9ry.de\", // \"Comment\" with quotes\n \"b\": [1, 2, 3,],}",
+                "[,1,,2,]",
+                "{\"a\":,\"b\":1}",
+                "{\"a\":1,\"a\":2}",
+                "[1 2 \"x\"\"y\"] trailing",
+                "{\"a\": [[], {}, [[null]]], \"b\": {\"c\": {\"d\": 18446744073709551615}}}"
+            };
+            for (const string &d : docs) {
+                json x;
+                x.parse(d);
+                for (size_t n : {1, 2, 3, 7, 1000}) {
+                    json y = push(d, n);
+                    assert(x.isDefined() == y.isDefined());
+                    assert(x.write() == y.write());
+                }
+            }
+
+            for (const char *d : {"[1,\n  2,\n  x]", "{\"a\" 1}", "[1,2", "[\"abc", "[}]",
+                                  "\"\\q\"", "{\"a\":1\n", "[1// Comment\n]", "{/", "[tru"}) {
+                string e1;
+                try {
+                    json x;
+                    x.parse(d);
+                }
+                catch (const exception &ex) {
+                    e1 = ex.what();
+                }
+                assert(!e1.empty());
+                for (size_t n : {1, 2, 1000}) {
+                    string e2;
+                    try {
+                        push(d, n);
+                    }
+                    catch (const exception &ex) {
+                        e2 = ex.what();
+                    }
+                    assert(e1 == e2);
+                }
+            }
+
+            // Several values, fed as they arrive:
+            json_push_parser p;
+            vector<string> values;
+            const string stream{"{\"id\": 1} [2,\n 3] \"four\" 5 // Comment\n"};
+            for (size_t i = 0; i < stream.size(); i += 4) {
+                const char *data = stream.data() + i;
+                size_t size = min<size_t>(4, stream.size() - i);
+                while (size > 0) {
+                    const size_t n = p.feed(data, size);
+                    data += n;
+                    size -= n;
+                    if (p.complete())
+                        values.push_back(p.take().write());
+                }
+            }
+            assert(p.depth() == 0);
+            p.finish();
+            assert(!p.take().isDefined());
+            assert((values == vector<string>{"{\"id\":1}", "[2,3]", "\"four\"", "5"}));
+            assert(p.line() == 3);
+
+            p.reset();
+            assert(p.feed("[1, [2") == 6);
+            assert(!p.complete());
+            assert(p.depth() == 2);
+            assert(p.feed("]]") == 2);
+            assert(p.complete());
+            assert(p.feed("[3]") == 0);
+            assert(p.take().write() == "[1,[2]]");
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing lazy documents:" << endl;
+        {
+            const string d{"{\"name\": \"Tab\\tstop\", \"list\": [1, -2, 3.5, null, \"abc\",,],"
+                           " \"obj\": {\"a\": true, \"a\": false, \"b\": {}, \"c\": }, // Comment\n"
+                           " \"k\\\"ey\": 7, \"big\": 18446744073709551615}"};
+            json x;
+            x.parse(d);
+            json_lazy lazy;
+            lazy.parse(d);
+            assert(lazy.root().isObject());
+            assert(lazy.root().size() == x.size());
+            assert(lazy.root().toJson().write() == x.write());
+            assert(lazy["name"].toString() == "Tab\tstop");
+            assert(lazy["name"].raw() == "\"Tab\\tstop\"");
+            assert(lazy["list"].size() == 5);
+            assert(lazy["list"][1].toSigned() == -2);
+            assert(lazy["list"][2].getType() == json::REAL_T);
+            assert(lazy["list"][3].isNull());
+            assert(lazy["list"][4].toString() == "abc");
+            assert(!lazy["list"][5].isDefined());
+            assert(lazy["obj"]["a"].isDefined() && !lazy["obj"]["a"].toBool());
+            assert(lazy["obj"].size() == 2);
+            assert(!lazy["obj"]["c"].isDefined());
+            assert(lazy["obj"]["b"].isObject() && (lazy["obj"]["b"].size() == 0));
+            assert(lazy["k\"ey"].toInt() == 7);
+            assert(lazy["big"].toUnsigned() == 18446744073709551615ULL);
+            assert(!lazy["missing"]["deeper"][0].isDefined());
+            assert(lazy["list"].toJson() == x["list"]);
+
+            json_lazy scalar;
+            scalar.parse(string("-12"));
+            assert(scalar.root().toSigned() == -12);
+            scalar.parse("");
+            assert(!scalar.root().isDefined());
+
+            json_lazy file;
+            file.parse_file("./test.jsonc");
+            json y;
+            y.parse_file("./test.jsonc");
+            assert(file["plugins"][1]["services"][0]["port"].toInt() == 8000);
+            assert(file.root().toJson() == y);
+
+            for (const char *s : {"[1, 2", "[1}", "{\"a\": [}", "{\"a\": [1, {\"b\": 2]]}"}) {
+                bool failed{false};
+                try {
+                    lazy.parse(s);
+                }
+                catch (const exception &) {
+                    failed = true;
+                }
+                assert(failed);
+                // Nothing is left of the failed parse:
+                assert(!lazy.root().isDefined());
+                assert(!lazy[0].isDefined() && !lazy["a"][1]["b"].isDefined());
+                assert(lazy.root().size() == 0);
+                lazy.parse("{\"a\": [1, {\"b\": 2}]}");
+                assert(lazy["a"][1]["b"].toInt() == 2);
+                assert(lazy["a"].size() == 2);
+            }
+            bool failed{false};
+            try {
+                lazy.parse("[1, x, 3]");
+                assert(lazy[0].toInt() == 1);
+                assert(lazy[2].toInt() == 3);
+                lazy[1].toInt();
+            }
+            catch (const exception &ex) {
+                failed = true;
+                assert(string(ex.what()) == "Syntax error Unexpected token: \"x\" in line 1, column 7");
+            }
+            assert(failed);
+
+            // Errors in a subtree report their position in the document:
+            const string bad{"{\"a\": 1,\n \"b\": 2,\n \"c\": [3],\n \"list\": [1, x]}"};
+            string expected;
+            try {
+                json().parse(bad);
+            }
+            catch (const exception &ex) {
+                expected = ex.what();
+            }
+            assert(expected.find("in line 4,") != string::npos);
+            lazy.parse(bad);
+            assert(lazy["c"].toJson().write() == "[3]");
+            string e;
+            try {
+                lazy["list"].toJson();
+            }
+            catch (const exception &ex) {
+                e = ex.what();
+            }
+            assert(e == expected);
+
+            // Conversions of containers and of values that are no strings:
+            lazy.parse("{\"list\": [1, [2, 3], {}], \"n\": 12.5}");
+            assert(lazy["list"].toInt() == 3);
+            assert(lazy["list"].toBool() && !lazy["list"][2].toBool());
+            assert(lazy["list"][1].toReal() == 2.0);
+            assert(lazy["n"].toUnsigned() == 13);
+            assert(lazy["n"].toString().empty() && lazy["list"].toString().empty());
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing NDJSON reader:" << endl;
+        {
+            string d;
+            for (int i = 0; i < 20000; ++i) {
+                d += "{\"n\": " + to_string(i) + ", \"s\": \"line " + to_string(i) + "\"}\n";
+                if (i % 1000 == 0)
+                    d += "\n   \r\n// Comment\n";
+            }
+            d += "[\"last line without newline\"]";
+            for (size_t threads : {0, 1, 4}) {
+                for (size_t batch : {100, 64 * 1024}) {
+                    ndjson_reader reader(threads, batch);
+                    int n{0};
+                    bool ordered{true};
+                    auto check = [&](json &&v) {
+                        if (n < 20000)
+                            ordered = ordered && (v["n"] == n) && (v["s"] == "line " + to_string(n));
+                        else
+                            ordered = ordered && (v[0] == "last line without newline");
+                        ++n;
+                    };
+                    reader.parse(d, check);
+                    assert(ordered && (n == 20001));
+                    n = 0;
+                    istringstream is(d);
+                    reader.parse(is, check);
+                    assert(ordered && (n == 20001));
+                }
+            }
+
+            // Records before an error are delivered:
+            ndjson_reader reader(4, 10);
+            const string bad{"1\n2\n\n[3,\n4\n"};
+            vector<int> seen;
+            string e;
+            try {
+                reader.parse(bad, [&](json &&v) { seen.push_back(v.toInt()); });
+            }
+            catch (const exception &ex) {
+                e = ex.what();
+            }
+            assert((seen == vector<int>{1, 2}));
+            assert(e == "Syntax error Premature EOF in line 1, column 4 of the record in line 4");
+
+            // And exceptions of the callback stop reading:
+            seen.clear();
+            e.clear();
+            try {
+                reader.parse(d, [&](json &&) {
+                    if (seen.size() == 100)
+                        throw runtime_error("Enough");
+                    seen.push_back(0);
+                });
+            }
+            catch (const exception &ex) {
+                e = ex.what();
+            }
+            assert((seen.size() == 100) && (e == "Enough"));
+
+            // From tasks that occupy every worker of the shared pool:
+            thread_pool &pool = thread_pool::shared();
+            vector<int> counts(pool.size());
+            vector<future<void>> done;
+            for (int &count : counts)
+                done.push_back(pool.submit([&]() {
+                    ndjson_reader shared_reader(0, 1000);
+                    shared_reader.parse(d, [&](json &&) { count += 1; });
+                }));
+            for (future<void> &f : done)
+                f.get();
+            for (int count : counts)
+                assert(count == 20001);
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing CBOR:" << endl;
+        {
+            // Examples of RFC 8949, appendix A:
+            const vector<pair<json, const char*>> encoded{
+                {json(0u), "00"},
+                {json(23u), "17"},
+                {json(24u), "1818"},
+                {json(1000u), "1903e8"},
+                {json(1000000u), "1a000f4240"},
+                {json(uint64_t(1000000000000)), "1b000000e8d4a51000"},
+                {json(numeric_limits<uint64_t>::max()), "1bffffffffffffffff"},
+                {json(-1), "20"},
+                {json(-100), "3863"},
+                {json(-1000), "3903e7"},
+                {json(1.1), "fb3ff199999999999a"},
+                {json(100000.0), "fa47c35000"},
+                {json(3.4028234663852886e+38), "fa7f7fffff"},
+                {json(1.0e+300), "fb7e37e43c8800759c"},
+                {json(true), "f5"},
+                {json::null, "f6"},
+                {json(), "f7"},
+                {json(""), "60"},
+                {json("IETF"), "6449455446"},
+                {json(json::ARRAY_T), "80"},
+                {jarray(1u, 2u, 3u), "83010203"}
+            };
+            for (const auto &e : encoded) {
+                assert(to_cbor(e.first) == from_hex(e.second));
+                json v = from_cbor(from_hex(e.second));
+                assert(v.getType() == e.first.getType());
+                assert(!v.isDefined() || (v == e.first));
+            }
+            json x;
+            x.parse("{\"a\": 1, \"b\": [2, 3]}");
+            assert(to_cbor(x) == from_hex("a26161016162820203"));
+
+            // Other encodings of the decoder:
+            assert(from_cbor(from_hex("f93c00")).toReal() == 1.0);
+            assert(from_cbor(from_hex("f97bff")).toReal() == 65504.0);
+            assert(from_cbor(from_hex("f90001")).toReal() == 5.960464477539063e-8);
+            assert(from_cbor(from_hex("f9fc00")).toReal() == -numeric_limits<double>::infinity());
+            assert(from_cbor(from_hex("3bffffffffffffffff")).toReal() == -18446744073709551616.0);
+            assert(from_cbor(from_hex("c11a514b67b0")).toUnsigned() == 1363896240u);
+            assert(from_cbor(from_hex("5f42010243030405ff")).toString() == string("\x01\x02\x03\x04\x05"));
+            assert(from_cbor(from_hex("7f657374726561646d696e67ff")).toString() == "streaming");
+            assert(from_cbor(from_hex("9f018202039f0405ffff")).write() == "[1,[2,3],[4,5]]");
+            assert(from_cbor(from_hex("bf61610161629f0203ffff")).write() == x.write());
+
+            // Round trip, with the types and undefined values kept:
+            json y;
+            y.parse("{\"id\": 17, \"delta\": -3, \"ratio\": 0.1, \"name\": \"Tab\\tstop\","
+                    " \"list\": [null, true, false, \"\", [], {}, 1e300, -1.5],"
+                    " \"big\": 18446744073709551615, \"small\": -9223372036854775808}");
+            y["list"].emplaceBack(json());
+            y.addUndefined("gone");
+            json z = from_cbor(to_cbor(y));
+            assert(to_cbor(z) == to_cbor(y));
+            assert(z["delta"].getType() == json::SIGNED_T);
+            assert(z["big"].getType() == json::UNSIGNED_T);
+            assert(z["small"].toSigned() == numeric_limits<int64_t>::min());
+            assert(z["list"].size() == 9);
+            assert(!z["list"][8].isDefined());
+            assert(z.write() == y.write());
+            string appended{"head"};
+            to_cbor(y, appended);
+            assert(appended == "head" + to_cbor(y));
+
+            for (const char *bad : {"", "19", "62616263", "8301", "a1016161", "ff", "1c",
+                                    "f818", "5f6161ff", "0000"}) {
+                bool failed{false};
+                try {
+                    from_cbor(from_hex(bad));
+                }
+                catch (const exception &ex) {
+                    failed = (string(ex.what()).find("Invalid CBOR: ") == 0);
+                }
+                assert(failed);
+            }
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing MessagePack:" << endl;
+        {
+            const vector<pair<json, const char*>> encoded{
+                {json(0u), "00"},
+                {json(127u), "7f"},
+                {json(128u), "cc80"},
+                {json(256u), "cd0100"},
+                {json(65536u), "ce00010000"},
+                {json(uint64_t(1) << 32), "cf0000000100000000"},
+                {json(-1), "ff"},
+                {json(-32), "e0"},
+                {json(-33), "d0df"},
+                {json(-129), "d1ff7f"},
+                {json(-32769), "d2ffff7fff"},
+                {json(numeric_limits<int64_t>::min()), "d38000000000000000"},
+                {json(1.5), "ca3fc00000"},
+                {json(1.1), "cb3ff199999999999a"},
+                {json(""), "a0"},
+                {json("IETF"), "a449455446"},
+                {json::null, "c0"},
+                {json(false), "c2"},
+                {json(true), "c3"},
+                {jarray(1u, 2u, 3u), "93010203"}
+            };
+            for (const auto &e : encoded) {
+                assert(to_msgpack(e.first) == from_hex(e.second));
+                json v = from_msgpack(from_hex(e.second));
+                assert(v.getType() == e.first.getType());
+                assert(v == e.first);
+            }
+            assert(to_msgpack(json(5)) == from_hex("05"));
+            assert(to_msgpack(json(string(31, 'x'))) == from_hex("bf") + string(31, 'x'));
+            assert(to_msgpack(json(string(32, 'x'))) == from_hex("d920") + string(32, 'x'));
+            assert(to_msgpack(json(string(256, 'x'))) == from_hex("da0100") + string(256, 'x'));
+            assert(to_msgpack(json(string(65536, 'x'))) == from_hex("db00010000") + string(65536, 'x'));
+            json items;
+            for (unsigned i = 0; i < 16; ++i)
+                items.add(i);
+            assert(to_msgpack(items).substr(0, 4) == from_hex("dc001000"));
+            json x;
+            x.parse("{\"a\": 1}");
+            assert(to_msgpack(x) == from_hex("81a16101"));
+
+            // Other formats of the decoder:
+            assert(from_msgpack(from_hex("d0ff")).toSigned() == -1);
+            assert(from_msgpack(from_hex("cc05")).getType() == json::UNSIGNED_T);
+            assert(from_msgpack(from_hex("c403616263")).toString() == "abc");
+            assert(from_msgpack(from_hex("de0001c4016101")).write() == "{\"a\":1}");
+            assert(!from_msgpack(string()).isDefined());
+            assert(to_msgpack(json()).empty());
+
+            // Round trip, undefined items and members are left out:
+            json y;
+            y.parse("{\"id\": 17, \"delta\": -3, \"ratio\": 0.1, \"name\": \"Tab\\tstop\","
+                    " \"list\": [null, true, false, \"\", [], {}, 1e300, -1.5],"
+                    " \"big\": 18446744073709551615, \"small\": -9223372036854775808}");
+            y["list"].emplaceBack(json());
+            y.addUndefined("gone");
+            json z = from_msgpack(to_msgpack(y));
+            json expected;
+            expected.parse(y.write());
+            assert(z.write() == expected.write());
+            assert(z["delta"].getType() == json::SIGNED_T);
+            assert(z["big"].getType() == json::UNSIGNED_T);
+            assert(z["list"].size() == 8);
+            assert(to_msgpack(z) == to_msgpack(y));
+            string appended{"head"};
+            to_msgpack(y, appended);
+            assert(appended == "head" + to_msgpack(y));
+
+            // Into the arena of a document:
+            json_document doc;
+            y["name"] = string(100, 'n');
+            expected["name"] = y["name"];
+            from_msgpack(doc, to_msgpack(y));
+            assert(doc.root().write() == expected.write());
+            assert(doc["name"].toStringView() == string(100, 'n'));
+
+            for (const char *bad : {"c1", "d40102", "cc", "9201", "810101", "a3616263ff", "0000"}) {
+                bool failed{false};
+                try {
+                    from_msgpack(doc, from_hex(bad));
+                }
+                catch (const exception &ex) {
+                    failed = (string(ex.what()).find("Invalid MessagePack: ") == 0);
+                }
+                assert(failed);
+                assert(!doc.root().isDefined());
+            }
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
+        cout << "Testing tape:" << endl;
+        {
+            json x;
+            x.parse("{\"id\": 17, \"delta\": -3, \"ratio\": 0.1, \"name\": \"Tab\\tstop\","
+                    " \"list\": [null, true, false, \"\", [], {}, 1e300, -1.5],"
+                    " \"big\": 18446744073709551615, \"small\": -9223372036854775808,"
+                    " \"records\": [{\"b\": 1, \"a\": 2}, {\"b\": 3, \"a\": 4}]}");
+            x.addUndefined("gone");
+            json_tape tape;
+            tape.open(to_tape(x));
+            assert(tape.root().isObject());
+            assert(tape.root().size() == x.size());
+            assert(tape.root().toJson().write() == x.write());
+            assert(tape["id"].getType() == json::UNSIGNED_T);
+            assert(tape["id"].toInt() == 17);
+            assert(tape["delta"].toSigned() == -3);
+            assert(tape["ratio"].toReal() == 0.1);
+            assert(tape["name"].toStringView() == "Tab\tstop");
+            assert(strcmp(tape["name"].c_str(), "Tab\tstop") == 0);
+            assert(tape["big"].toUnsigned() == 18446744073709551615ULL);
+            assert(tape["small"].toSigned() == numeric_limits<int64_t>::min());
+            assert(tape["list"].size() == 8);
+            assert(tape["list"][0].isNull());
+            assert(tape["list"][1].toBool() && !tape["list"][2].toBool());
+            assert(tape["list"][3].isString() && tape["list"][3].toStringView().empty());
+            assert(tape["list"][4].isArray() && (tape["list"][4].size() == 0));
+            assert(tape["list"][5].isObject() && (tape["list"][5].size() == 0));
+            assert(tape["list"][6].toReal() == 1e300);
+            assert(!tape["list"][8].isDefined());
+            assert(tape["records"][1]["a"].toInt() == 4);
+            assert(tape["records"][0].key(0).size() == 1);
+            assert(!tape["records"][0]["c"].isDefined());
+            assert(!tape["gone"].isDefined());
+            assert(!tape["missing"]["deeper"][0].isDefined());
+            assert(tape["list"].toJson() == x["list"]);
+            assert(tape["id"].toStringView().empty());
+            // Conversions of containers and of values that are no strings:
+            assert(tape["list"].toInt() == 8);
+            assert(tape["records"].toBool() && !tape["list"][4].toBool());
+            assert(tape["records"][0].toReal() == 2.0);
+            assert(tape["list"][7].toSigned() == -2);
+            assert(tape["list"][7].toUnsigned() == 0);
+            assert(tape["list"][1].toInt() == 1);
+            assert(tape["id"].toString().empty() && tape["list"].toString().empty());
+
+            // Keys not in order, and an undefined item:
+            json u;
+            u.add("z", 1);
+            u.add("y", 2);
+            u.add("x", 3);
+            u["items"].emplaceBack(json());
+            u["items"].add(5);
+            tape.open(to_tape(u));
+            assert(tape["x"].toInt() == 3);
+            assert(tape["z"].toInt() == 1);
+            assert(!tape["w"].isDefined());
+            assert(tape["items"].size() == 2);
+            assert(!tape["items"][0].isDefined());
+            assert(tape["items"][1].toInt() == 5);
+
+            // Scalars and empty values:
+            tape.open(to_tape(json("abc")));
+            assert(tape.root().toString() == "abc");
+            assert(tape.root().size() == 1);
+            tape.open(to_tape(json()));
+            assert(!tape.root().isDefined());
+
+            // Mapped from a file:
+            {
+                ofstream ofs("./test.tape", ios::binary);
+                to_tape(x, ofs);
+            }
+            tape.open_file("./test.tape");
+            assert(tape.root().toJson().write() == x.write());
+            assert(tape["records"][0]["b"].toInt() == 1);
+            std::remove("./test.tape");
+
+            // Data that is no tape:
+            string t = to_tape(x);
+            vector<uint64_t> words((t.size() + 15) / 8);
+            memcpy(reinterpret_cast<char*>(words.data()) + 1, t.data(), t.size());
+            for (size_t i = 0; i < 4; ++i) {
+                bool failed{false};
+                try {
+                    switch (i) {
+                    case 0:
+                        tape.open(reinterpret_cast<const char*>(words.data()) + 1, t.size());
+                        break;
+                    case 1:
+                        tape.open(string("{\"a\": 1}"));
+                        break;
+                    case 2:
+                        tape.open(t.substr(0, t.size() - 8));
+                        break;
+                    default:
+                        {
+                            string damaged{t};
+                            damaged[32 + 7] = 0x7f;
+                            tape.open(std::move(damaged));
+                            tape.root().getType();
+                        }
+                    } // end switch //
+                }
+                catch (const exception &) {
+                    failed = true;
+                }
+                assert(failed);
+            }
+        }
+        cout << "OK" << endl;
+        cout << endl;
+
         cout << "Testing IO:" << endl;
         {
             ifstream ifs;
@@ -492,6 +2083,28 @@ int main(int, const char *[])
             ifs.open("./test.json");
             document.parse(ifs);
         }
+        {
+            ifstream ifs("./test.jsonc");
+            json d1, d2, d3;
+            d1.parse(ifs);
+            d2.parse_file("./test.jsonc");
+            d3.parse_file("./test.jsonc", json::INDEX_E);
+            assert(d1["name"] == "Baukasten main test configuration");
+            assert(d2["plugins"][1]["services"][0]["port"] == 8000);
+            assert(d1 == d2);
+            assert(d1 == d3);
+
+            bool failed{false};
+            try {
+                d2.parse_file("./does-not-exist.jsonc");
+            }
+            catch (const exception &) {
+                failed = true;
+            }
+            assert(failed);
+        }
+        cout << "OK" << endl;
+        cout << endl;
 
         cout << "JsonX Test FINISHED" << endl;
         return EXIT_SUCCESS;
@@ -0,0 +1,73 @@
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace jsonx {
+
+// Pool the calling thread works for:
+static thread_local const thread_pool *current_pool{nullptr};
+
+thread_pool::thread_pool(size_t threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, thread::hardware_concurrency());
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+        workers.emplace_back([this]() { work(); });
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (thread &t : workers)
+        t.join();
+}
+
+std::future<void> thread_pool::submit(std::function<void()> task)
+{
+    packaged_task<void()> t(std::move(task));
+    std::future<void> f = t.get_future();
+    {
+        lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(t));
+    }
+    ready.notify_one();
+    return f;
+}
+
+thread_pool &thread_pool::shared()
+{
+    static thread_pool pool;
+    return pool;
+}
+
+bool thread_pool::is_worker() const
+{
+    return current_pool == this;
+}
+
+void thread_pool::work()
+{
+    current_pool = this;
+    while (true) {
+        packaged_task<void()> t;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            t = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        t();
+    }
+}
+
+} // end namespace jsonx //
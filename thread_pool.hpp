@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Fixed set of worker threads that run submitted tasks in order.
+ *        Tasks must not wait for other tasks of the same pool.
+ */
+class thread_pool
+{
+public:
+    // threads == 0: one per hardware thread
+    explicit thread_pool(size_t threads = 0);
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    // Runs the queued tasks, then joins the threads:
+    ~thread_pool();
+
+    size_t size() const { return workers.size(); }
+
+    /**
+     * @brief The calling thread is a worker of this pool, so waiting for
+     *        tasks submitted to it could deadlock.
+     */
+    bool is_worker() const;
+
+    /**
+     * @brief Queue task. The future reports its completion and
+     *        passes on exceptions.
+     */
+    std::future<void> submit(std::function<void()> task);
+
+    /**
+     * @brief Pool shared by the parallel functions of the library,
+     *        created on first use.
+     */
+    static thread_pool &shared();
+
+private:
+    void work();
+
+    std::mutex                             mutex;
+    std::condition_variable                ready;
+    std::deque<std::packaged_task<void()>> tasks;
+    std::vector<std::thread>               workers;
+    bool                                   stopping{false};
+}; // end class thread_pool //
+
+} // end namespace jsonx //
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,243 @@
+
+#include "jsonx.hpp"
+#include "writer.hpp"
+#include "simd.hpp"
+#include "number.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+using namespace std;
+
+namespace jsonx {
+
+writer::writer(std::string &s): str{&s}
+{
+    const size_t size = s.size();
+    s.resize(std::max(s.capacity(), size + 256));
+    first = s.data();
+    pos = first + size;
+    last = first + s.size();
+}
+
+writer::writer(char *data, size_t size): first{data}, pos{data}, last{data + size}
+{
+}
+
+writer::writer(std::ostream &_os): os{&_os}, block(BLOCK_SIZE)
+{
+    first = pos = block.data();
+    last = first + block.size();
+}
+
+size_t writer::finish()
+{
+    if (str) {
+        str->resize(pos - first);
+        return str->size();
+    }
+    if (os) {
+        os->write(first, pos - first);
+        flushed += pos - first;
+        pos = first;
+        return flushed;
+    }
+    return pos - first;
+}
+
+void writer::put_slow(const char *data, size_t n)
+{
+    while (n > 0) {
+        if (pos == last)
+            grow(n);
+        const size_t chunk = std::min(n, static_cast<size_t>(last - pos));
+        memcpy(pos, data, chunk);
+        pos += chunk;
+        data += chunk;
+        n -= chunk;
+    }
+}
+
+void writer::grow(size_t n)
+{
+    if (str) {
+        const size_t used = pos - first;
+        str->resize(std::max(2 * str->size(), used + n));
+        first = str->data();
+        pos = first + used;
+        last = first + str->size();
+    } else if (os) {
+        os->write(first, pos - first);
+        flushed += pos - first;
+        pos = first;
+    } else {
+        throw runtime_error("Buffer too small");
+    }
+}
+
+template <class T>
+void writer::write_number(T v)
+{
+    if (static_cast<size_t>(last - pos) >= NUMBER_SIZE) {
+        pos = to_chars(pos, pos + NUMBER_SIZE, v).ptr;
+    } else {
+        // Near the end of the buffer:
+        char tmp[NUMBER_SIZE];
+        put(tmp, to_chars(tmp, tmp + NUMBER_SIZE, v).ptr - tmp);
+    }
+}
+
+void writer::write_real(json_real_t v)
+{
+    if (static_cast<size_t>(last - pos) >= real_size) {
+        pos = format_real(pos, v);
+    } else {
+        char tmp[real_size];
+        put(tmp, format_real(tmp, v) - tmp);
+    }
+}
+
+void writer::write_string(std::string_view s)
+{
+    put('"');
+    const char *p = s.data();
+    const char *end = p + s.size();
+    while (p != end) {
+        // Copy the run up to the next character that may need escaping:
+        const char *q = find_string_special(p, end);
+        put(p, q - p);
+        if (q == end)
+            break;
+        switch (*q) {
+        case '\0':
+            put("\\0", 2);
+            break;
+        case '\"':
+            put("\\\"", 2);
+            break;
+        case '\\':
+            put("\\\\", 2);
+            break;
+        case '\b':
+            put("\\b", 2);
+            break;
+        case '\f':
+            put("\\f", 2);
+            break;
+        case '\n':
+            put("\\n", 2);
+            break;
+        case '\r':
+            put("\\r", 2);
+            break;
+        case '\t':
+            put("\\t", 2);
+            break;
+        default:
+            put(*q);
+            break;
+        } // end switch //
+        p = q + 1;
+    }
+    put('"');
+}
+
+void writer::write_items(const json *first, const json *last)
+{
+    for (const json *p = first; p != last; ++p) {
+        if (p != first)
+            put(',');
+        write(*p);
+    }
+}
+
+void writer::write_members(json_object_t::const_iterator first,
+                           json_object_t::const_iterator last, bool comma_first)
+{
+    bool comma{comma_first};
+    for (; first != last; ++first) {
+        if (first->second.isDefined()) {
+            if (comma)
+                put(',');
+            comma = true;
+            write_string(first->first);
+            put(':');
+            write(first->second);
+        }
+    }
+}
+
+void writer::write_array(const json_array_t &v)
+{
+    put('[');
+    write_items(v.data(), v.data() + v.size());
+    put(']');
+}
+
+void writer::write_object(const json_object_t &v)
+{
+    put('{');
+    write_members(v.begin(), v.end(), false);
+    put('}');
+}
+
+void writer::write(const json &v)
+{
+    switch (v.getType()) {
+    case json::UNDEFINED_T:
+        break;
+    case json::NULL_T:
+        put("null", 4);
+        break;
+    case json::BOOL_T:
+        if (v.toBool())
+            put("true", 4);
+        else
+            put("false", 5);
+        break;
+    case json::SIGNED_T:
+        write_number(v.toSigned());
+        break;
+    case json::UNSIGNED_T:
+        write_number(v.toUnsigned());
+        break;
+    case json::REAL_T:
+        write_real(v.toReal());
+        break;
+    case json::STRING_T:
+        write_string(v.toStringView());
+        break;
+    case json::ARRAY_T:
+        write_array(v.toArray());
+        break;
+    case json::OBJECT_T:
+        write_object(v.toObject());
+        break;
+    default:
+        cerr << "jsonx::json: Invalid data type " << v.getType() << endl;
+    } // end switch //
+}
+
+void json::write(std::ostream &os) const
+{
+    writer w(os);
+    w.write(*this);
+    w.finish();
+}
+
+void json::write_to(std::string &s) const
+{
+    writer w(s);
+    w.write(*this);
+    w.finish();
+}
+
+size_t json::write_to(char *data, size_t size) const
+{
+    writer w(data, size);
+    w.write(*this);
+    return w.finish();
+}
+
+} // end namespace jsonx //
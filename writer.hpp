@@ -0,0 +1,98 @@
+#ifndef WRITER_HPP
+#define WRITER_HPP
+
+#include "jsonx.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jsonx {
+
+/**
+ * @brief Serializer into a contiguous buffer.
+ *        The buffer is either the tail of a growing std::string, a fixed
+ *        range supplied by the caller or an internal block that is flushed
+ *        to an output stream whenever it is full.
+ *        Call finish() when done, the destructor does not flush.
+ */
+class writer
+{
+public:
+    static const size_t BLOCK_SIZE{16 * 1024};
+
+    // Appends to s:
+    writer(std::string &s);
+    // Writes into [data, data + size), throws when it is too small:
+    writer(char *data, size_t size);
+    // Writes to os in blocks:
+    writer(std::ostream &os);
+    writer(const writer&) = delete;
+    writer& operator=(const writer&) = delete;
+
+    void write(const json &v);
+    void write_string(std::string_view s);
+    // Items separated by commas, without the brackets:
+    void write_items(const json *first, const json *last);
+    // Defined members, each preceded by a comma if comma_first,
+    // else all but the first one:
+    void write_members(json_object_t::const_iterator first,
+                       json_object_t::const_iterator last, bool comma_first);
+
+    /**
+     * @brief Flush the buffer and trim a string to its content.
+     * @return Number of bytes written in total.
+     */
+    size_t finish();
+
+    // Raw output:
+    void put(char ch)
+    {
+        if (pos == last)
+            grow(1);
+        *pos++ = ch;
+    }
+
+    void put(const char *data, size_t n)
+    {
+        if (static_cast<size_t>(last - pos) < n) {
+            put_slow(data, n);
+            return;
+        }
+        memcpy(pos, data, n);
+        pos += n;
+    }
+
+    void put(std::string_view s)
+    {
+        put(s.data(), s.size());
+    }
+
+private:
+    // Room for any integer:
+    static const size_t NUMBER_SIZE{32};
+
+    void put_slow(const char *data, size_t n);
+    // Make room for n more bytes, or as many as the buffer can hold:
+    void grow(size_t n);
+
+    template <class T> void write_number(T v);
+    void write_real(json_real_t v);
+    void write_array(const json_array_t &v);
+    void write_object(const json_object_t &v);
+
+    char              *first{nullptr};
+    char              *pos{nullptr};
+    char              *last{nullptr};
+    std::string       *str{nullptr};
+    std::ostream      *os{nullptr};
+    std::vector<char>  block;
+    size_t             flushed{0};
+}; // end class writer //
+
+} // end namespace jsonx //
+
+#endif // WRITER_HPP